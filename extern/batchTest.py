@@ -7,9 +7,6 @@ import numpy as np
 import pandas as pd
 from sklearn.datasets import fetch_openml
 
-def div(x: int) -> float:
-    return float(x) / 85
-
 # Load the MNIST dataset
 print("-> Fetching dataset...")
 dataset = "mnist_784"
@@ -21,13 +18,8 @@ images, labels = mnist["data"], mnist["target"] # type: ignore
 end = time.time()
 print(f"-> Done, took {(end - start):.5f} seconds")
 
-print("-> Mapping scale function to dataset...")
-start = time.time()
-images = images.to_numpy()[0:100]
-vectorized_div = np.vectorize(div)
-images = vectorized_div(images)
-end = time.time()
-print(f"-> Done, took {(end - start):.5f} seconds")
+# pixels are scaled by 1 / 85 as runBatch reads them
+images = images.to_numpy(dtype=np.uint8)[0:100]
 
 # images = [[1.0,1.0,1.0,1.0,1.0,1.0,1.0,1.0,1.0], [1.0,1.0,1.0,1.0,1.0,1.0,1.0,1.0,1.0],[1.0,1.0,1.0,1.0,1.0,1.0,1.0,1.0,1.0],[1.0,1.0,1.0,1.0,1.0,1.0,1.0,1.0,1.0], [1.0,1.0,1.0,1.0,1.0,1.0,1.0,1.0,1.0]]
 # dataset = "dummy"
@@ -56,7 +48,7 @@ y = []
 
 for i in range(1,5):
     start = time.time()
-    net.runBatch(images[0:i])
+    net.runBatch(images[0:i], 1 / 85)
     end = time.time()
     x.append(i)
     y.append(end - start)
@@ -0,0 +1,52 @@
+#include "activation_histogram.hpp"
+#include <sys/mman.h>
+
+/**
+ * @param bins number of bins, at least 1
+ * @param time_per_stimulus last timestamp of a stimulus
+ */
+TimeBins::TimeBins(size_t bins, int time_per_stimulus)
+    : bins(bins ? bins : 1) {
+  size_t range = time_per_stimulus + 1;
+  size_t bin_size = range / this->bins;
+  size_t remainder = range % this->bins;
+  for (uint32_t bin = 0; bin < this->bins; bin++) {
+    size_t size = bin_size + (bin < remainder ? 1 : 0);
+    bin_of.insert(bin_of.end(), size, bin);
+  }
+}
+
+/**
+ * @brief Allocate zeroed counts.
+ *
+ * If mapping the counts fails ActivationHistogram::isValid is false and
+ * ActivationHistogram::add does nothing.
+ *
+ * @param number_stimuli rows
+ * @param number_neurons neurons counted on their own, 0 to sum them
+ * @param bins time bins per row, at least 1
+ * @param time_per_stimulus last timestamp of a stimulus
+ */
+ActivationHistogram::ActivationHistogram(size_t number_stimuli,
+                                         size_t number_neurons, size_t bins,
+                                         int time_per_stimulus)
+    : number_stimuli(number_stimuli), number_neurons(number_neurons),
+      bin_of(bins, time_per_stimulus) {
+  size_t cells = number_stimuli * bin_of.size() *
+                 (number_neurons ? number_neurons : 1);
+  if (cells == 0) {
+    return;
+  }
+  void *mem = mmap(nullptr, cells * sizeof(int), PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (mem != MAP_FAILED) {
+    counts = static_cast<int *>(mem);
+  }
+}
+
+ActivationHistogram::~ActivationHistogram() {
+  if (counts) {
+    munmap(counts, number_stimuli * bin_of.size() *
+                       (number_neurons ? number_neurons : 1) * sizeof(int));
+  }
+}
@@ -0,0 +1,85 @@
+/** @file */
+#ifndef ACTIVATION_HISTOGRAM
+#define ACTIVATION_HISTOGRAM
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Bin of every timestamp of a stimulus.
+ *
+ * `time_per_stimulus + 1` timestamps split into `bins` ranges, the first ones
+ * one larger if they do not divide evenly, like `get_thresholds`/`bindex` of
+ * the Python bindings but through a table instead of a search.
+ */
+class TimeBins {
+private:
+  size_t bins;
+  std::vector<uint32_t> bin_of; /**< by timestamp */
+
+public:
+  TimeBins(size_t bins, int time_per_stimulus);
+
+  /** Later timestamps fall into the last bin */
+  size_t operator()(uint32_t timestamp) const {
+    return timestamp < bin_of.size() ? bin_of[timestamp] : bins - 1;
+  }
+  size_t size() const { return bins; }
+};
+
+/**
+ * @brief Activation counts binned by time, updated as neurons fire.
+ *
+ * A `[stimulus x bin]` array, or `[stimulus x neuron x bin]` when counting
+ * every Neuron on its own, of `int`s. NeuronGroup::addActivation increments
+ * it directly, so the counts are ready when a run ends without going through
+ * the logged `SpikeRecord`s.
+ *
+ * The counts live in anonymous shared memory: children forked after the
+ * histogram is created (pySNN::forkRun) count into the same array as their
+ * parent. Groups of the same stimulus run on different threads, increments
+ * are therefore atomic. Timestamps are binned by TimeBins.
+ */
+class ActivationHistogram {
+private:
+  int *counts = nullptr;
+  size_t number_stimuli;
+  size_t number_neurons; /**< 0 if the neurons are summed */
+  TimeBins bin_of;
+
+public:
+  ActivationHistogram(size_t number_stimuli, size_t number_neurons,
+                      size_t bins, int time_per_stimulus);
+  ActivationHistogram(const ActivationHistogram &) = delete;
+  ActivationHistogram &operator=(const ActivationHistogram &) = delete;
+  ~ActivationHistogram();
+
+  /**
+   * @brief Count an activation.
+   *
+   * @param stimulus row, stimuli out of range are ignored
+   * @param neuron Neuron::getGlobalIndex, ignored if the neurons are summed
+   * @param timestamp start of the refractory period
+   */
+  void add(uint32_t stimulus, uint32_t neuron, uint32_t timestamp) {
+    if (counts == nullptr || stimulus >= number_stimuli) {
+      return;
+    }
+    size_t bins = bin_of.size();
+    size_t bin = bin_of(timestamp);
+    size_t cell = number_neurons
+                      ? (stimulus * number_neurons + neuron) * bins + bin
+                      : stimulus * bins + bin;
+    __atomic_fetch_add(&counts[cell], 1, __ATOMIC_RELAXED);
+  }
+
+  bool isValid() const { return counts != nullptr; }
+  bool isIndividual() const { return number_neurons != 0; }
+  int *data() { return counts; }
+  size_t getNumberStimuli() const { return number_stimuli; }
+  size_t getNumberNeurons() const { return number_neurons; }
+  size_t getBins() const { return bin_of.size(); }
+};
+
+#endif // !ACTIVATION_HISTOGRAM
@@ -0,0 +1,239 @@
+#include "../calendar_queue.hpp"
+#include "../decay_table.hpp"
+#include "../network.hpp"
+#include "../neuron_group.hpp"
+#include "../pool.hpp"
+#include "../runtime.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+/*
+ * Benchmarks for the simulation hot path.
+ *
+ * Usage: build/bench [config.toml]
+ *
+ * Without arguments only the synthetic benchmarks are run. Passing the name of
+ * a configuration file in ./run_config/ additionally builds a random network
+ * from it and times SNN::start.
+ */
+
+using bench_clock = std::chrono::high_resolution_clock;
+
+struct BenchEvent {
+  int timestamp;
+  int target;
+};
+
+struct BenchEventComp {
+  bool operator()(const BenchEvent *lhs, const BenchEvent *rhs) const {
+    return lhs->timestamp < rhs->timestamp;
+  }
+};
+
+/*
+ * Synthetic workload shaped like a stimulus: a batch of input events spread
+ * over [0, time_per_stimulus), then every popped event fans out to a few
+ * neighbours `delay` ticks later.
+ */
+struct QueueWorkload {
+  int time_per_stimulus = 200;
+  int max_delay = 3;
+  int stimulus_events = 140000;
+  int fan_out = 3;
+  double fire_probability = 0.3;
+};
+
+template <typename Push, typename Pop, typename Empty>
+size_t runWorkload(const QueueWorkload &w, Push push, Pop pop, Empty empty) {
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<> time(0, w.time_per_stimulus - 1);
+  std::uniform_int_distribution<> delay(1, w.max_delay);
+  std::uniform_real_distribution<> roll(0.0, 1.0);
+
+  for (int i = 0; i < w.stimulus_events; i++) {
+    push(BenchEvent{time(gen), i});
+  }
+
+  size_t processed = 0;
+  while (!empty()) {
+    BenchEvent e = pop();
+    processed++;
+    if (roll(gen) < w.fire_probability) {
+      for (int i = 0; i < w.fan_out; i++) {
+        int t = e.timestamp + delay(gen);
+        if (t <= w.time_per_stimulus) {
+          push(BenchEvent{t, e.target});
+        }
+      }
+    }
+  }
+  return processed;
+}
+
+void reportRate(const char *name, size_t events, double seconds) {
+  printf("  %-28s %10zu events %8.4f s %12.0f events/s\n", name, events,
+         seconds, events / seconds);
+}
+
+/*
+ * std::multiset<Message *, comparator> (the old NeuronGroup::message_q)
+ * against CalendarQueue with the same workload and one heap allocation per
+ * event in both cases, then CalendarQueue holding indices into a FreeListPool
+ * (the current NeuronGroup::message_q).
+ */
+void benchMessageQueue() {
+  QueueWorkload w;
+  printf("Message queue (%d stimulus events, time_per_stimulus %d)\n",
+         w.stimulus_events, w.time_per_stimulus);
+
+  {
+    std::multiset<BenchEvent *, BenchEventComp> q;
+    auto start = bench_clock::now();
+    size_t n = runWorkload(
+        w, [&](BenchEvent e) { q.insert(new BenchEvent(e)); },
+        [&]() {
+          BenchEvent *e = *q.begin();
+          q.erase(q.begin());
+          BenchEvent ret = *e;
+          delete e;
+          return ret;
+        },
+        [&]() { return q.empty(); });
+    std::chrono::duration<double> elapsed = bench_clock::now() - start;
+    reportRate("std::multiset", n, elapsed.count());
+  }
+  {
+    CalendarQueue<BenchEvent *> q(w.time_per_stimulus + w.max_delay + 1);
+    auto start = bench_clock::now();
+    size_t n = runWorkload(
+        w, [&](BenchEvent e) { q.push(new BenchEvent(e), e.timestamp); },
+        [&]() {
+          BenchEvent *e = q.pop();
+          BenchEvent ret = *e;
+          delete e;
+          return ret;
+        },
+        [&]() { return q.empty(); });
+    std::chrono::duration<double> elapsed = bench_clock::now() - start;
+    reportRate("CalendarQueue", n, elapsed.count());
+  }
+  {
+    FreeListPool<BenchEvent> pool;
+    CalendarQueue<uint32_t> q(w.time_per_stimulus + w.max_delay + 1);
+    auto start = bench_clock::now();
+    size_t n = runWorkload(
+        w, [&](BenchEvent e) { q.push(pool.acquire(e), e.timestamp); },
+        [&]() { return pool.release(q.pop()); }, [&]() { return q.empty(); });
+    std::chrono::duration<double> elapsed = bench_clock::now() - start;
+    reportRate("CalendarQueue + FreeListPool", n, elapsed.count());
+    printf("  %-28s %10zu allocations for %zu events\n", "FreeListPool",
+           pool.getAllocationCount(), pool.getAcquiredCount());
+  }
+}
+
+/*
+ * NeuronGroup::retroactiveDecay on long stimuli: every neuron receives a
+ * handful of messages spread over time_per_stimulus, so the step by step
+ * reference does O(time_per_stimulus) work per neuron while DecayTable does
+ * O(1) per message.
+ */
+void benchDecay() {
+  const int messages_per_neuron = 8;
+  const int neurons = 20000;
+  const double tau = 150.0;
+  const double v_rest = -7.0;
+
+  for (int time_per_stimulus : {200, 2000, 20000}) {
+    printf("Decay (time_per_stimulus %d, %d messages)\n", time_per_stimulus,
+           neurons * messages_per_neuron);
+
+    // sorted message timestamps for every neuron
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<> time(0, time_per_stimulus);
+    std::uniform_real_distribution<> input(0.0, 3.0);
+    std::vector<int> timestamps(neurons * messages_per_neuron);
+    std::vector<double> inputs(timestamps.size());
+    for (int n = 0; n < neurons; n++) {
+      auto first = timestamps.begin() + n * messages_per_neuron;
+      for (auto it = first; it != first + messages_per_neuron; it++) {
+        *it = time(gen);
+      }
+      std::sort(first, first + messages_per_neuron);
+    }
+    for (auto &v : inputs) {
+      v = input(gen);
+    }
+
+    DecayTable table;
+    table.build(tau, DecayTable::steps(0, time_per_stimulus) + 1);
+
+    double reference_sum = 0;
+    double closed_sum = 0;
+    for (int mode = 0; mode < 2; mode++) {
+      double sum = 0;
+      auto start = bench_clock::now();
+      for (int n = 0; n < neurons; n++) {
+        double potential = v_rest;
+        int last_decay = 0;
+        for (int m = 0; m < messages_per_neuron; m++) {
+          int i = n * messages_per_neuron + m;
+          if (mode == 0) {
+            last_decay = DecayTable::reference(potential, v_rest, tau,
+                                               last_decay, timestamps[i]);
+          } else {
+            int steps = DecayTable::steps(last_decay, timestamps[i]);
+            potential = table.decay(potential, v_rest, steps);
+            last_decay += DecayTable::time_step * steps;
+          }
+          potential += inputs[i];
+        }
+        sum += potential;
+      }
+      std::chrono::duration<double> elapsed = bench_clock::now() - start;
+      reportRate(mode == 0 ? "DecayTable::reference" : "DecayTable::decay",
+                 timestamps.size(), elapsed.count());
+      (mode == 0 ? reference_sum : closed_sum) = sum;
+    }
+    printf("  %-28s %10g\n", "sum of potentials differs by",
+           closed_sum - reference_sum);
+  }
+}
+
+/*
+ * Full network run from a configuration file.
+ */
+void benchNetwork(const std::string &configFile) {
+  SNN snn({"bench", configFile});
+  snn.generateRandomSynapsesAdjMatrix();
+
+  printf("Network (%s: %d neurons, %d edges, %zu stimulus)\n",
+         configFile.c_str(), snn.getConfig()->NUMBER_NEURONS,
+         snn.getConfig()->NUMBER_EDGES, snn.getConfig()->STIMULUS_VEC.size());
+
+  auto start = bench_clock::now();
+  snn.start();
+  std::chrono::duration<double> elapsed = bench_clock::now() - start;
+
+  size_t processed = 0;
+  size_t allocations = 0;
+  for (auto group : snn.getGroups()) {
+    processed += group->getProcessedCount();
+    allocations += group->getMessageAllocations();
+  }
+  reportRate("SNN::start", processed, elapsed.count());
+  printf("  %-28s %10zu allocations for %zu events\n", "Message pools",
+         allocations, processed);
+}
+
+int main(int argc, char **argv) {
+  benchMessageQueue();
+  benchDecay();
+  if (argc > 1) {
+    benchNetwork(argv[1]);
+  }
+}
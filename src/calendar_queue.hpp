@@ -0,0 +1,164 @@
+/** @file */
+#ifndef CALENDAR_QUEUE
+#define CALENDAR_QUEUE
+
+#include <climits>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Bucketed calendar queue keyed on an integer timestamp.
+ *
+ * Timestamps in a run are small, bounded integers (0 to time_per_stimulus plus
+ * the maximum synapse delay), so instead of a balanced tree we keep one bucket
+ * per tick in a ring. Elements that share a timestamp are popped in the order
+ * they were pushed, matching the old std::multiset behaviour.
+ *
+ * Push and pop are O(1) amortized. Bucket vectors keep their capacity after
+ * being drained, so a warmed up queue does not allocate.
+ *
+ * The ring always covers the queued timestamps, pushing a timestamp outside of
+ * it grows the ring when needed. A timestamp before the last popped element (a
+ * late intergroup message) is placed in the bucket being drained.
+ */
+template <typename T> class CalendarQueue {
+private:
+  std::vector<std::vector<T>> buckets;
+  size_t mask = 0;      /**< buckets.size() - 1, size is always a power of 2 */
+  int current = 0;      /**< Timestamp of the bucket being drained */
+  int last = 0;         /**< Upper bound on the queued timestamps */
+  int floor = INT_MIN;  /**< Timestamp of the most recently popped element */
+  size_t cursor = 0;    /**< Read position in the current bucket */
+  size_t count = 0;     /**< Number of queued elements */
+
+  std::vector<T> &bucket(int timestamp) {
+    return buckets[static_cast<size_t>(timestamp) & mask];
+  }
+
+  void grow(size_t span) {
+    size_t capacity = buckets.empty() ? 1 : buckets.size();
+    while (capacity < span) {
+      capacity <<= 1;
+    }
+    std::vector<std::vector<T>> resized(capacity);
+    for (size_t i = 0; i < buckets.size(); i++) {
+      int timestamp = current + static_cast<int>(i);
+      resized[static_cast<size_t>(timestamp) & (capacity - 1)] =
+          std::move(bucket(timestamp));
+    }
+    buckets = std::move(resized);
+    mask = capacity - 1;
+  }
+
+public:
+  CalendarQueue(size_t span = 256) { grow(span); }
+
+  /**
+   * @brief Make sure `span` consecutive ticks fit without growing.
+   */
+  void reserve(size_t span) {
+    if (span > buckets.size()) {
+      grow(span);
+    }
+  }
+
+  /**
+   * @brief Add an element at a timestamp.
+   *
+   * Timestamps earlier than the last popped element are placed in the bucket
+   * currently being drained.
+   *
+   * @param value element to add
+   * @param timestamp tick at which the element should be popped
+   */
+  void push(const T &value, int timestamp) {
+    if (timestamp < floor) {
+      timestamp = floor;
+    }
+    if (count == 0) {
+      current = last = timestamp;
+      cursor = 0;
+    } else if (timestamp < current || timestamp > last) {
+      int lo = timestamp < current ? timestamp : current;
+      int hi = timestamp > last ? timestamp : last;
+      size_t span = static_cast<size_t>(hi - lo) + 1;
+      if (span > buckets.size()) {
+        grow(span);
+      }
+      current = lo;
+      last = hi;
+    }
+    bucket(timestamp).push_back(value);
+    count++;
+  }
+
+  /**
+   * @brief Timestamp of the oldest element.
+   *
+   * Must not be called on an empty queue.
+   */
+  int frontTime() {
+    while (cursor == bucket(current).size()) {
+      bucket(current).clear();
+      cursor = 0;
+      current++;
+    }
+    return current;
+  }
+
+  /**
+   * @brief Remove and return the oldest element.
+   *
+   * Must not be called on an empty queue.
+   */
+  T pop() {
+    frontTime();
+    T ret = bucket(current)[cursor++];
+    floor = current;
+    count--;
+    if (count == 0) {
+      bucket(current).clear();
+      cursor = 0;
+    }
+    return ret;
+  }
+
+  /**
+   * @brief Timestamp of the bucket currently being drained.
+   */
+  int currentTime() const { return current; }
+  bool empty() const { return count == 0; }
+  size_t size() const { return count; }
+
+  /**
+   * @brief Drop every element and keep the bucket storage.
+   *
+   * Also forgets the last popped timestamp so the next run may start at 0.
+   */
+  void clear() {
+    for (auto &b : buckets) {
+      b.clear();
+    }
+    current = last = 0;
+    floor = INT_MIN;
+    cursor = 0;
+    count = 0;
+  }
+
+  /**
+   * @brief Visit every queued element in timestamp order.
+   */
+  template <typename F> void forEach(F func) const {
+    size_t seen = 0;
+    for (size_t i = 0; seen < count; i++) {
+      const std::vector<T> &b =
+          buckets[static_cast<size_t>(current + static_cast<int>(i)) & mask];
+      for (size_t j = i == 0 ? cursor : 0; j < b.size(); j++) {
+        func(b[j]);
+        seen++;
+      }
+    }
+  }
+};
+
+#endif // !CALENDAR_QUEUE
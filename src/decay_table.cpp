@@ -0,0 +1,113 @@
+#include "decay_table.hpp"
+#include <cmath>
+
+/**
+ * @brief Precompute the ratio powers for a given tau.
+ *
+ * Decays longer than `max_steps` fall back to std::pow.
+ *
+ * @param _tau RuntimConfig::TAU
+ * @param max_steps longest decay expected in a stimulus, in steps
+ */
+void DecayTable::build(double _tau, int max_steps) {
+  tau = _tau;
+  ratio = 1.0 - 1.0 / tau;
+  powers.resize(max_steps + 1);
+  double p = 1.0;
+  for (int k = 0; k <= max_steps; k++) {
+    powers[k] = p;
+    p *= ratio;
+  }
+}
+
+double DecayTable::power(int k) const {
+  if (k < size()) {
+    return powers[k];
+  }
+  return std::pow(ratio, k);
+}
+
+/**
+ * @brief Number of decay steps taken between two timestamps.
+ *
+ * The decay starts at `from` and takes a step every DecayTable::time_step
+ * until `to` is reached, so the new last decay is `from + time_step * steps`.
+ */
+int DecayTable::steps(int from, int to) {
+  if (to <= from) {
+    return 0;
+  }
+  return (to - from + time_step - 1) / time_step;
+}
+
+/**
+ * @brief Number of the `steps` steps that decay by at least min_decay.
+ *
+ * The decay of step `j` is `distance * r^j / tau`, which only shrinks with
+ * `j`. The count is estimated with a logarithm and then corrected against the
+ * table so it agrees with the decay DecayTable::decay actually applies.
+ *
+ * @param distance potential - v_rest before the first step
+ * @param steps number of steps available
+ */
+int DecayTable::appliedSteps(double distance, int steps) const {
+  if (steps <= 0 || distance / tau < min_decay) {
+    return 0;
+  }
+
+  // distance * r^j / tau >= min_decay for j < applied
+  double estimate =
+      std::log(min_decay * tau / distance) / std::log(ratio) + 1.0;
+  int applied = estimate < steps ? static_cast<int>(estimate) : steps;
+  if (applied < 1) {
+    applied = 1;
+  }
+  while (applied > 1 && distance * power(applied - 1) / tau < min_decay) {
+    applied--;
+  }
+  while (applied < steps && distance * power(applied) / tau >= min_decay) {
+    applied++;
+  }
+  return applied;
+}
+
+/**
+ * @brief Decay a membrane potential by `steps` steps.
+ *
+ * @param potential membrane potential before the decay
+ * @param v_rest resting potential (RuntimConfig::REFRACTORY_MEMBRANE_POTENTIAL)
+ * @param steps number of steps, see DecayTable::steps
+ * @return membrane potential after the decay
+ */
+double DecayTable::decay(double potential, double v_rest, int steps) const {
+  double distance = potential - v_rest;
+  int applied = appliedSteps(distance, steps);
+  if (applied == 0) {
+    return potential;
+  }
+  return v_rest + distance * power(applied);
+}
+
+/**
+ * @brief Decay by applying every step in turn.
+ *
+ * @param potential membrane potential, decayed in place
+ * @param from timestamp of the last decay
+ * @param to timestamp to decay to
+ * @return the new last decay timestamp
+ */
+int DecayTable::reference(double &potential, double v_rest, double tau,
+                          int from, int to) {
+  int i;
+  for (i = from; i < to; i += time_step) {
+
+    double decay_value = (potential - v_rest) / tau;
+
+    if (decay_value < 0 || decay_value < min_decay) {
+      continue;
+    }
+
+    potential -= decay_value;
+  }
+  return i;
+}
@@ -0,0 +1,45 @@
+/** @file */
+#ifndef DECAY_TABLE
+#define DECAY_TABLE
+
+#include <vector>
+
+/**
+ * @brief Closed form of the membrane potential decay.
+ *
+ * Every decay step moves the membrane potential towards the resting potential
+ * by `(potential - v_rest) / tau`, so after `k` steps the distance to the
+ * resting potential is `distance * r^k` with `r = 1 - 1 / tau`. Steps stop
+ * once a step would decay by less than DecayTable::min_decay, which only
+ * depends on the distance. A decay over any number of steps is therefore one
+ * lookup of `r^k` instead of a loop over every step.
+ *
+ * DecayTable::reference is the per step loop used before, kept for
+ * RuntimConfig::decay_mode Reference.
+ */
+class DecayTable {
+public:
+  static constexpr int time_step = 3;        /**< timestamps per decay step */
+  static constexpr double min_decay = 0.0001; /**< smallest decay applied */
+
+  void build(double tau, int max_steps);
+  bool valid() const { return ratio > 0; }
+  double getTau() const { return tau; }
+  int size() const { return static_cast<int>(powers.size()); }
+
+  static int steps(int from, int to);
+  int appliedSteps(double distance, int steps) const;
+  double decay(double potential, double v_rest, int steps) const;
+
+  static int reference(double &potential, double v_rest, double tau, int from,
+                       int to);
+
+private:
+  double tau = 0;
+  double ratio = 0;
+  std::vector<double> powers; /**< powers[k] is ratio^k */
+
+  double power(int k) const;
+};
+
+#endif // !DECAY_TABLE
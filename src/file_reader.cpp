@@ -1,13 +1,264 @@
 #include "file_reader.hpp"
+#include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <cmath>
 #include <cstdio>
+#include <cstring>
+#include <fcntl.h>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <unordered_map>
 #include <vector>
 
+/**
+ * @brief Map the file and index its stimuli.
+ *
+ * @param file_path Input file file path, the extension picks the format
+ * @param start_pos Line to start reading
+ * @param columns values per row of a `.f32` file
+ */
+InputFileReader::InputFileReader(const std::string &file_path, int start_pos,
+                                 size_t columns)
+    : current_line(start_pos) {
+  auto endsWith = [&](const char *extension) {
+    size_t length = strlen(extension);
+    return file_path.size() >= length &&
+           file_path.compare(file_path.size() - length, length, extension) == 0;
+  };
+  if (endsWith(".npy")) {
+    format = Format::Npy;
+  } else if (endsWith(".f32")) {
+    format = Format::Raw;
+  }
+
+  int fd = open(file_path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    void *mem = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mem != MAP_FAILED) {
+      data = static_cast<const char *>(mem);
+      size = st.st_size;
+    }
+  }
+  close(fd);
+  if (data == nullptr) {
+    return;
+  }
+
+  switch (format) {
+  case Format::Text:
+    indexLines();
+    break;
+  case Format::Npy:
+    if (!mapNpy()) {
+      lg.string(ERROR,
+                "InputFileReader: %s is not a 2D float32, float64 or uint8 "
+                "npy file",
+                file_path.c_str());
+    }
+    break;
+  case Format::Raw:
+    if (columns) {
+      matrix = InputMatrix(data, size / (columns * sizeof(float)), columns,
+                           columns * sizeof(float), sizeof(float),
+                           InputMatrix::Type::FLOAT32);
+    }
+    break;
+  }
+}
+
+InputFileReader::~InputFileReader() {
+  if (data) {
+    munmap(const_cast<char *>(data), size);
+  }
+}
+
+void InputFileReader::indexLines() {
+  line_starts.push_back(0);
+  const char *end = data + size;
+  for (const char *newline = data;
+       (newline = static_cast<const char *>(
+            memchr(newline, '\n', end - newline))) != nullptr;) {
+    newline++;
+    if (newline == end) {
+      break;
+    }
+    line_starts.push_back(newline - data);
+  }
+}
+
+/**
+ * @brief Point InputFileReader::matrix past the header of an npy file.
+ *
+ * The header is a Python dict literal like
+ * `{'descr': '<f4', 'fortran_order': False, 'shape': (60000, 784), }`.
+ *
+ * @return false if the file is not a 2D array of a supported type
+ */
+bool InputFileReader::mapNpy() {
+  if (size < 10 || memcmp(data, "\x93NUMPY", 6) != 0) {
+    return false;
+  }
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+  size_t header_start = bytes[6] == 1 ? 10 : 12;
+  if (size < header_start) {
+    return false;
+  }
+  size_t header_length = bytes[8] | bytes[9] << 8;
+  if (bytes[6] != 1) {
+    header_length |= size_t(bytes[10]) << 16 | size_t(bytes[11]) << 24;
+  }
+  if (size < header_start + header_length) {
+    return false;
+  }
+  std::string_view header(data + header_start, header_length);
+
+  auto valueOf = [&](std::string_view key) {
+    size_t at = header.find(key);
+    if (at == std::string_view::npos) {
+      return std::string_view();
+    }
+    at = header.find(':', at) + 1;
+    while (at < header.size() && header[at] == ' ') {
+      at++;
+    }
+    return header.substr(at);
+  };
+
+  std::string_view descr = valueOf("'descr'");
+  InputMatrix::Type type;
+  size_t element;
+  if (descr.substr(0, 5) == "'<f4'") {
+    type = InputMatrix::Type::FLOAT32;
+    element = sizeof(float);
+  } else if (descr.substr(0, 5) == "'<f8'") {
+    type = InputMatrix::Type::FLOAT64;
+    element = sizeof(double);
+  } else if (descr.substr(0, 5) == "'|u1'") {
+    type = InputMatrix::Type::UINT8;
+    element = sizeof(uint8_t);
+  } else {
+    return false;
+  }
+  bool fortran = valueOf("'fortran_order'").substr(0, 4) == "True";
+
+  std::string_view shape = valueOf("'shape'");
+  size_t dimensions[2];
+  const char *cursor = shape.data() + 1;
+  const char *end = shape.data() + shape.size();
+  for (size_t &dimension : dimensions) {
+    while (cursor < end && (*cursor == ' ' || *cursor == ',')) {
+      cursor++;
+    }
+    auto result = std::from_chars(cursor, end, dimension);
+    if (result.ec != std::errc()) {
+      return false;
+    }
+    cursor = result.ptr;
+  }
+  size_t rows = dimensions[0];
+  size_t columns = dimensions[1];
+  if (size - header_start - header_length < rows * columns * element) {
+    return false;
+  }
+
+  const char *first = data + header_start + header_length;
+  if (fortran) {
+    matrix = InputMatrix(first, rows, columns, element, rows * element, type);
+  } else {
+    matrix =
+        InputMatrix(first, rows, columns, columns * element, element, type);
+  }
+  return true;
+}
+
+/**
+ * @brief Line `index` of a text file, counted from 0.
+ *
+ * @return line without its newline, empty past the last line
+ */
+std::string_view InputFileReader::line(size_t index) const {
+  if (index >= line_starts.size()) {
+    return {};
+  }
+  size_t begin = line_starts[index];
+  size_t end = index + 1 < line_starts.size() ? line_starts[index + 1] - 1
+                                               : size;
+  if (end > begin && data[end - 1] == '\n') {
+    end--;
+  }
+  return std::string_view(data + begin, end - begin);
+}
+
+size_t InputFileReader::lineCount() const {
+  return format == Format::Text ? line_starts.size() : matrix.rows();
+}
+
+/**
+ * @brief Values of the next stimulus, one per element of `values`.
+ *
+ * Values missing from the file are 0.
+ */
+void InputFileReader::nextStimulus(std::vector<double> &values) {
+  size_t row = current_line++;
+  if (format == Format::Text) {
+    parseValues(line(row), values.data(), values.size());
+    return;
+  }
+  for (size_t i = 0; i < values.size(); i++) {
+    values[i] = row < matrix.rows() && i < matrix.columns()
+                    ? matrix.at(row, i)
+                    : 0.0;
+  }
+}
+
+/**
+ * @brief Parse up to `count` numbers of a text line.
+ *
+ * Numbers are separated by whitespace and at most one other character that
+ * cannot start a number, e.g. `0.1 0.2`, `0.1,0.2` or `0.1, 0.2`.
+ *
+ * @return number of values parsed, the rest of `values` is set to 0
+ */
+size_t InputFileReader::parseValues(std::string_view line, double *values,
+                                    size_t count) {
+  const char *cursor = line.data();
+  const char *end = cursor + line.size();
+  auto skipSpace = [&]() {
+    while (cursor < end && std::isspace(static_cast<unsigned char>(*cursor))) {
+      cursor++;
+    }
+  };
+
+  size_t parsed = 0;
+  for (; parsed < count; parsed++) {
+    skipSpace();
+    if (cursor < end && *cursor == '+') {
+      cursor++;
+    }
+    auto result = std::from_chars(cursor, end, values[parsed]);
+    if (result.ec != std::errc()) {
+      break;
+    }
+    cursor = result.ptr;
+    skipSpace();
+    if (cursor < end && !std::isdigit(static_cast<unsigned char>(*cursor)) &&
+        *cursor != '-' && *cursor != '+' && *cursor != '.') {
+      cursor++;
+    }
+  }
+  std::fill(values + parsed, values + count, 0.0);
+  return parsed;
+}
+
 /**
  * @brief Parse a line of the AdjList.
  *
@@ -1,9 +1,11 @@
 #ifndef FILEREADER
 #define FILEREADER
+#include "input_matrix.hpp"
 #include "log.hpp"
 #include <fstream>
 #include <limits>
 #include <optional>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -56,48 +58,64 @@ public:
   AdjListInfo parseAdjList();
   void assignFormat();
 };
+/**
+ * @brief Stimuli of RuntimConfig::INPUT_FILE, read in place.
+ *
+ * The file is memory mapped, forked children share the mapping with their
+ * parent. Three formats are read, one stimulus per line or row:
+ *
+ * - text, numbers separated by whitespace or a single separator such as `,`.
+ *   The offset of every line is indexed once when the file is opened (one
+ *   `memchr` pass), seeking to a stimulus is an index lookup and the numbers
+ *   are parsed with `std::from_chars` straight out of the mapping.
+ * - `.npy`, a 2D numpy array of float32, float64 or uint8 (`np.save`), in C
+ *   or Fortran order.
+ * - `.f32`, raw float32 rows of as many values as there are input neurons.
+ *
+ * Binary files are not parsed at all, values are read through an InputMatrix
+ * over the mapping. A file that cannot be opened reads as zeros, like a
+ * failed `std::getline` did.
+ */
 class InputFileReader {
 public:
-  /**
-   * @brief Constructor for FileReader.
-   *
-   * @param file_path Input file file path
-   * @param start_pos Line to start reading
-   */
-  InputFileReader(const std::string &file_path, int start_pos)
-      : file(file_path) {
-    for (int i = 0; i < start_pos; i++) {
-      file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    }
-    current_position = file.tellg();
-  }
+  enum class Format { Text, Npy, Raw };
+
+  Log lg;
+
+  InputFileReader(const std::string &file_path, int start_pos,
+                  size_t columns = 0);
+  InputFileReader(const InputFileReader &) = delete;
+  InputFileReader &operator=(const InputFileReader &) = delete;
+  ~InputFileReader();
+
+  void nextStimulus(std::vector<double> &values);
 
   /**
-   * @brief Retrieve the next line of the input file.
-   *
-   * Return the next line of the input file
+   * @brief Retrieve the next line of a text file.
    *
-   * @return string containing line
+   * @return line without its newline, valid as long as the reader
    */
-  std::string nextLine() {
-    std::string line;
-    std::getline(file, line);
-    current_position = file.tellg();
-    return line;
-  }
+  std::string_view nextLine() { return line(current_line++); }
 
-  void setToLine(int targetLine) {
-    file.clear();
-    file.seekg(0);
-    for (int i = 0; i < targetLine; i++) {
-      file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    }
-    current_position = file.tellg();
-  }
+  std::string_view line(size_t index) const;
+  void setToLine(int targetLine) { current_line = targetLine; }
+  /** Number of stimuli (lines or rows) in the file */
+  size_t lineCount() const;
+  Format getFormat() const { return format; }
+
+  static size_t parseValues(std::string_view line, double *values,
+                            size_t count);
 
 private:
-  std::ifstream file;
-  std::streampos current_position;
+  Format format = Format::Text;
+  const char *data = nullptr;
+  size_t size = 0;
+  std::vector<size_t> line_starts; /**< offset of every line, text only */
+  InputMatrix matrix;              /**< binary only */
+  size_t current_line = 0;
+
+  void indexLines();
+  bool mapNpy();
 };
 
 #endif // !FILEREADER
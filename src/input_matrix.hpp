@@ -0,0 +1,92 @@
+/** @file */
+#ifndef INPUT_MATRIX
+#define INPUT_MATRIX
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Read-only `[stimulus x input]` values, viewed in place.
+ *
+ * Points at someone else's memory, e.g. the buffer of a numpy array handed to
+ * pySNN::runBatch, and reads an element through its byte strides, converting
+ * it to `double` and multiplying it by a scale factor on the way. Nothing is
+ * copied no matter the layout or element type of the array, forked children
+ * read the rows straight out of the memory they inherited.
+ *
+ * A matrix built from `std::vector`s (SNN::start reading the input file) owns
+ * its values instead. Moving it keeps them where they are, copying is not
+ * allowed.
+ */
+class InputMatrix {
+public:
+  enum class Type { FLOAT64, FLOAT32, UINT8 };
+
+private:
+  const char *base = nullptr;
+  size_t number_rows = 0;
+  size_t number_columns = 0;
+  ptrdiff_t row_stride = 0;    /**< in bytes */
+  ptrdiff_t column_stride = 0; /**< in bytes */
+  Type type = Type::FLOAT64;
+  double scale = 1.0;
+  std::vector<double> owned;
+
+public:
+  InputMatrix() = default;
+
+  /**
+   * @param base first element
+   * @param rows stimuli
+   * @param columns inputs per stimulus
+   * @param row_stride bytes from one stimulus to the next
+   * @param column_stride bytes from one input to the next
+   * @param type element type
+   * @param scale every element is multiplied by it
+   */
+  InputMatrix(const void *base, size_t rows, size_t columns,
+              ptrdiff_t row_stride, ptrdiff_t column_stride, Type type,
+              double scale = 1.0)
+      : base(static_cast<const char *>(base)), number_rows(rows),
+        number_columns(columns), row_stride(row_stride),
+        column_stride(column_stride), type(type), scale(scale) {}
+
+  /**
+   * @brief Take a copy of equally long rows.
+   */
+  explicit InputMatrix(const std::vector<std::vector<double>> &rows)
+      : number_rows(rows.size()),
+        number_columns(rows.empty() ? 0 : rows.front().size()) {
+    owned.reserve(number_rows * number_columns);
+    for (const auto &row : rows) {
+      owned.insert(owned.end(), row.begin(), row.begin() + number_columns);
+    }
+    base = reinterpret_cast<const char *>(owned.data());
+    row_stride = number_columns * sizeof(double);
+    column_stride = sizeof(double);
+  }
+
+  InputMatrix(InputMatrix &&) = default;
+  InputMatrix &operator=(InputMatrix &&) = default;
+  InputMatrix(const InputMatrix &) = delete;
+  InputMatrix &operator=(const InputMatrix &) = delete;
+
+  double at(size_t row, size_t column) const {
+    const char *element = base + row * row_stride + column * column_stride;
+    switch (type) {
+    case Type::FLOAT32:
+      return *reinterpret_cast<const float *>(element) * scale;
+    case Type::UINT8:
+      return *reinterpret_cast<const uint8_t *>(element) * scale;
+    default:
+      return *reinterpret_cast<const double *>(element) * scale;
+    }
+  }
+
+  size_t rows() const { return number_rows; }
+  size_t columns() const { return number_columns; }
+  bool empty() const { return number_rows == 0; }
+};
+
+#endif // !INPUT_MATRIX
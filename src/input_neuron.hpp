@@ -17,14 +17,11 @@ protected:
 
 public:
   InputNeuron(int _id, NeuronGroup *group, int latency);
-  void reset() override;
-  void run(Message *message) override;
-  bool poissonResult() const;
   void setInputValue(long double value);
   void setLatency(int latency);
   void setProbabilityOfSucess(double pSucc) { probalility_of_success = pSucc; }
-  void generateEvents();
-  void generateEvents(const std::vector<int> &timestamps);
+  void joinStimulus();
+  void joinStimulus(long double value, NeuronGroup *into) const;
   bool inRefractory() const;
   double getInputValue() const { return input_value; }
   int getLatency() const { return latency; }
@@ -2,7 +2,10 @@
 #include "message.hpp"
 #include "network.hpp"
 #include "neuron.hpp"
+#include "result_region.hpp"
 #include "runtime.hpp"
+#include "spike_buffer.hpp"
+#include <algorithm>
 #include <bits/types/struct_timeval.h>
 #include <chrono>
 #include <filesystem>
@@ -104,29 +107,64 @@ void Log::log(LogLevel level, const char *message,
 }
 
 /**
- * @brief Add data to Log::log_data.
+ * @brief Append activations to Log::spikes.
  *
+ * @param records e.g. the SpikeRecords of a Neuron or a mapped ResultRegion
+ * @param count number of records
+ */
+void Log::addSpikes(const SpikeRecord *records, size_t count) {
+  spikes.insert(spikes.end(), records, records + count);
+}
+
+/**
+ * @brief Append every record of `buffer` to Log::spikes, a chunk at a time.
+ */
+void Log::addSpikes(const SpikeBuffer &buffer) {
+  spikes.reserve(spikes.size() + buffer.size());
+  buffer.forEachChunk([this](const SpikeRecord *records, size_t count) {
+    addSpikes(records, count);
+  });
+}
+
+/**
+ * @brief Every field of an activation.
+ *
+ * The potential is the Neuron's current refractory potential, which is what
+ * it was set to when the Neuron fired unless it was changed since.
+ */
+LogData Log::expand(const SpikeRecord &spike) const {
+  const Neuron *neuron = network->getNeurons().at(spike.neuron);
+  NeuronGroup *group = neuron->getGroup();
+  return LogData(neuron->getID(), group->getID(), spike.timestamp,
+                 group->getState().refractory_potential[neuron->getIndex()],
+                 neuron->getType(), Message_t::Refractory, spike.stimulus);
+}
+
+/**
+ * @brief Write the activations of every Neuron into `region`, child side.
  *
- * @param data LogData instance
+ * @return false if the region could not be sized or mapped
  */
-void Log::addData(LogData *data) { this->log_data.push_back(data); }
-void Log::writeToFD(int fd, const std::vector<NeuronGroup *> &neuronGroups) {
-  this->value(LogLevel::INFO, "Log::writeToFD: Writing for Child Process %d",
-              getpid());
+bool Log::writeToRegion(ResultRegion &region,
+                        const std::vector<NeuronGroup *> &neuronGroups) {
+  size_t count = 0;
   for (const auto &group : neuronGroups) {
-    for (const auto &neuron : group->getNeuronVec()) {
-      LogDataArray DataArray =
-          neuron->getRefractoryArray(); // O(number log data)
-      if (DataArray.arrSize != 0) {
-        int writeRet =
-            write(fd, DataArray.array, DataArray.arrSize * sizeof(LogData));
-        if (writeRet == -1) {
-          this->log(LogLevel::ERROR, "Log::writeToFD returned -1");
-        }
-      }
-    }
+    count += group->getActivations().size();
+  }
+
+  SpikeRecord *out = region.reserve(count);
+  if (out == nullptr) {
+    this->log(LogLevel::ERROR, "Log::writeToRegion: unable to map region");
+    return false;
   }
-  close(fd);
+  for (const auto &group : neuronGroups) {
+    group->getActivations().forEachChunk(
+        [&out](const SpikeRecord *records, size_t count) {
+          out = std::copy(records, records + count, out);
+        });
+  }
+  region.commit(count);
+  return true;
 }
 
 void Log::writeCSV(const std::vector<std::vector<int>> &mat) {
@@ -203,12 +241,13 @@ void Log::writeData() {
     return;
   }
 
-  for (LogData *log_data : this->log_data) {
-    file << log_data->group_id << " " << log_data->neuron_id << " "
-         << neuronTypeString((Neuron_t)log_data->neuron_type) << " "
-         << log_data->timestamp << " " << log_data->potential << " "
-         << messageTypeToString(log_data->message_type) << " "
-         << log_data->stimulus_number << '\n';
+  for (const SpikeRecord &spike : spikes) {
+    LogData log_data = expand(spike);
+    file << log_data.group_id << " " << log_data.neuron_id << " "
+         << neuronTypeString((Neuron_t)log_data.neuron_type) << " "
+         << log_data.timestamp << " " << log_data.potential << " "
+         << messageTypeToString(log_data.message_type) << " "
+         << log_data.stimulus_number << '\n';
   }
 
   file.close();
@@ -461,6 +500,9 @@ std::string Log::messageTypeToString(Message_t type) {
   case Stimulus:
     ret = "S";
     break;
+  case Stimulus_Tick:
+    ret = "T";
+    break;
   case Refractory:
     ret = "R";
     break;
@@ -474,11 +516,7 @@ std::string Log::messageTypeToString(Message_t type) {
   return ret;
 }
 
-Log::~Log() {
-  for (auto d : log_data) {
-    delete d;
-  }
-}
+Log::~Log() {}
 
 void Log::printNetworkInfo() {
   RuntimConfig *cf = network->getConfig();
@@ -494,6 +532,3 @@ void Log::printNetworkInfo() {
             << "\t Time per Stimulus: " << cf->time_per_stimulus << "\n";
 }
 
-// LogData::LogData(const LogData4_t &lg_data4_t)
-//     : timestamp(lg_data4_t.timestamp), message_type(Message_t::Refractory),
-//       stimulus_number(lg_data4_t.stimulus_number) {}
@@ -9,10 +9,12 @@
 #include <vector>
 
 class SNN;
+class NeuronGroup;
+class ResultRegion;
+class SpikeBuffer;
 using std::cout;
 using std::ostream;
 using std::vector;
-// struct LogData4_t;
 
 /**
  * \enum LogLevel
@@ -41,20 +43,18 @@ enum LogLevel {
  *
  * @brief  Log data datastructure.
  *
- * Each Neuron holds their own vector of LogData * that gets transfered
- * to the main Log class upon thread joining.
+ * Every field of an activation, rebuilt from a SpikeRecord by Log::expand.
  *
  */
 struct LogData {
   int neuron_id;
-  int group_id; // ! TODO remove or change to char
+  int group_id;
   int timestamp;
-  double potential; // ! TODO CHANGE to float
+  double potential;
   int neuron_type = 0;
   Message_t message_type;
   int stimulus_number;
   LogData() {};
-  // LogData(const LogData4_t &lg_data4_t);
   LogData(int nID, int gID, int t, double p, int nt, Message_t mt, int sn)
       : neuron_id(nID), group_id(gID), timestamp(t), potential(p),
         neuron_type(nt), message_type(mt), stimulus_number(sn) {}
@@ -74,19 +74,23 @@ struct LogData {
   }
 };
 
-// struct LogData4_t {
-//   uint16_t timestamp = 0;
-//   uint16_t stimulus_number = 0;
-//   LogData4_t(const LogData &lg_data) {
-//     timestamp = static_cast<uint16_t>(lg_data.timestamp);
-//     stimulus_number = static_cast<uint16_t>(lg_data.stimulus_number);
-//   }
-//   LogData4_t() {}
-// };
-
-struct LogDataArray {
-  LogData *array;
-  size_t arrSize;
+/**
+ *
+ * \struct SpikeRecord
+ *
+ * @brief Packed activation, 12 bytes instead of the 40 of a LogData.
+ *
+ * Only refractory events are logged, so the Neuron alone determines its group,
+ * ID, type and potential (its refractory potential). Each NeuronGroup collects
+ * its records in a SpikeBuffer, which gets transfered to the main Log class
+ * upon thread joining, and forked children hand them back as they are
+ * (ResultRegion).
+ *
+ */
+struct SpikeRecord {
+  uint32_t neuron;    /**< Neuron::getGlobalIndex */
+  uint32_t stimulus;  /**< stimulus number */
+  uint32_t timestamp; /**< start of the refractory period */
 };
 using hr_clock = std::chrono::high_resolution_clock;
 using duration = std::chrono::duration<double>;
@@ -100,7 +104,7 @@ private:
   hr_clock::time_point start;
   double offset; /**< Global offset accouting for stimulus switching time */
   SNN *network;
-  vector<LogData *> log_data;
+  vector<SpikeRecord> spikes;
 
 public:
   Log(SNN *network) : start(hr_clock::now()), offset(0.0f), network(network) {}
@@ -109,18 +113,17 @@ public:
   void batchReset() {
     start = hr_clock::now();
     offset = 0.0f;
-    for (auto &data : log_data) {
-      delete data;
-      data = nullptr;
-    }
-    log_data.clear();
+    spikes.clear();
   }
   void startClock() { this->start = hr_clock::now(); }
   void writeData();
-  void writeToFD(int fd, const std::vector<NeuronGroup *> &neuronGroups);
+  bool writeToRegion(ResultRegion &region,
+                     const std::vector<NeuronGroup *> &neuronGroups);
   void writeCSV(const std::vector<std::vector<int>> &mat);
-  void addData(LogData *data);
-  const vector<LogData *> &getLogData() const { return log_data; }
+  void addSpikes(const SpikeRecord *records, size_t count);
+  void addSpikes(const SpikeBuffer &buffer);
+  const vector<SpikeRecord> &getSpikes() const { return spikes; }
+  LogData expand(const SpikeRecord &spike) const;
   void logConfig(const std::string &name);
   void log(LogLevel level, const char *message, ostream &os = std::cout);
   double time();
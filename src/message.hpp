@@ -1,45 +1,54 @@
 /** @file */
 #ifndef MESSAGE
 #define MESSAGE
-class NeuronGroup;
-class Neuron;
+#include <cstdint>
 
 /**
  * \enum Message_t
  * Message type.
+ *
+ * A Stimulus_Tick is not addressed to a Neuron, it applies the input values of
+ * the current stimulus to every InputNeuron of a group at once (see
+ * NeuronGroup::queueStimulus).
  */
-enum Message_t { Decay, Stimulus, From_Neighbor, Refractory };
+enum Message_t : uint8_t {
+  Decay,
+  Stimulus,
+  From_Neighbor,
+  Refractory,
+  Stimulus_Tick
+};
 
 /**
  *
  * \struct Message
  * Datastructure for messages.
  *
+ * Messages are packed into 16 bytes so that a queued stimulus fits in cache.
+ * The postsynaptic Neuron is identified by its index in the owning
+ * NeuronGroup (see Neuron::getIndex) rather than by pointer.
+ *
  */
 struct Message {
 public:
-  Message(double value, Neuron *origin, Neuron *target, Message_t type,
-          double timestamp);
-  double message;
-  Neuron *presynaptic_neuron;
-  Neuron *post_synaptic_neuron;
-  NeuronGroup *target_neuron_group;
-  int timestamp;
+  Message() = default;
+  Message(float value, uint32_t target, Message_t type, int32_t timestamp,
+          uint16_t origin_group = 0);
+  /** Index of the postsynaptic Neuron in its NeuronGroup, for a
+   * Stimulus_Tick the number of times the tick was drawn */
+  uint32_t target;
+  int32_t timestamp; /**< Tick at which the message is delivered */
+  float message;     /**< Value added to the membrane potential */
   Message_t message_type;
+  uint16_t origin_group; /**< ID of the sending NeuronGroup, 0 for Stimulus */
   bool operator>(const Message &other) const {
     return timestamp > other.timestamp;
   }
   bool operator<(const Message &other) const {
     return timestamp < other.timestamp;
   }
-
-  bool isInterGroup();
 };
 
-struct MessageComp {
-  bool operator()(const Message *lhs, const Message *rhs) const {
-    return lhs->timestamp < rhs->timestamp;
-  }
-};
+static_assert(sizeof(Message) == 16, "Message should stay 16 bytes");
 
 #endif // !MESSAGE
@@ -1,9 +1,12 @@
 #include "network.hpp"
+#include "activation_histogram.hpp"
 #include "file_reader.hpp"
 #include "log.hpp"
 #include "neuron.hpp"
 #include "neuron_group.hpp"
+#include "result_region.hpp"
 #include "runtime.hpp"
+#include "stimulus_pool.hpp"
 #include <algorithm>
 #include <asm-generic/ioctls.h>
 #include <cerrno>
@@ -16,10 +19,11 @@
 #include <fstream>
 #include <iomanip>
 #include <pthread.h>
-#include <random>
 #include <sstream>
 #include <string>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
+#include <sys/syscall.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <vector>
@@ -31,6 +35,7 @@
  *
  */
 SNN::~SNN() {
+  delete pool;
   for (auto group : groups) {
     if (group) {
       delete group;
@@ -63,15 +68,12 @@ SNN::SNN(std::vector<std::string> args) {
   config = new RuntimConfig(this);
   config->parseArgs(args);
   config->checkStartCond();
-  srand(config->RAND_SEED);
   mutex = new Mutex;
   // number of group threads plus the main thread
   barrier = new Barrier(config->NUMBER_GROUPS + 1);
   inputFileReader =
-      new InputFileReader(config->INPUT_FILE, config->STIMULUS_VEC.front());
-
-  gen = std::mt19937(rd());
-  gen.seed(config->RAND_SEED);
+      new InputFileReader(config->INPUT_FILE, config->STIMULUS_VEC.front(),
+                          config->NUMBER_INPUT_NEURONS);
 
   if (Image::isSquare(config->NUMBER_INPUT_NEURONS)) {
     lg->log(ESSENTIAL, "Assuming square input image");
@@ -119,10 +121,8 @@ void SNN::initializeFromSynapseFile(const std::vector<std::string> &args,
   barrier = new Barrier(config->NUMBER_GROUPS + 1);
 
   inputFileReader =
-      new InputFileReader(config->INPUT_FILE, config->STIMULUS_VEC.front());
-
-  gen = std::mt19937(rd());
-  gen.seed(config->RAND_SEED);
+      new InputFileReader(config->INPUT_FILE, config->STIMULUS_VEC.front(),
+                          config->NUMBER_INPUT_NEURONS);
 
   if (Image::isSquare(config->NUMBER_INPUT_NEURONS)) {
     lg->log(ESSENTIAL, "Assuming square input image");
@@ -255,10 +255,127 @@ void SNN::setInputNeuronLatency() {
  */
 void SNN::generateAllNeuronVec() {
   for (auto group : groups) {
+    group->setOffset(neurons.size());
     for (auto neuron : group->getMutNeuronVec()) {
       neurons.push_back(neuron);
     }
   }
+  graph.setNodes(neurons);
+}
+
+/**
+ * @brief RandomStream for `purpose` and the ids `a`, `b` and `c`.
+ *
+ * Keyed with RuntimConfig::RAND_SEED, see RandomStream.
+ */
+RandomStream SNN::getStream(Random_t purpose, uint32_t a, uint32_t b,
+                            uint32_t c) {
+  return RandomStream(config->RAND_SEED, purpose, a, b, c);
+}
+
+/**
+ * @brief Random weight for a new edge.
+ *
+ * Uniform in [0, RuntimConfig::max_weight), the first draw of the edge's
+ * stream.
+ *
+ * @param from global index of the presynaptic Neuron
+ * @param to global index of the postsynaptic Neuron
+ */
+double SNN::randomSynapseWeight(uint32_t from, uint32_t to) {
+  RandomStream stream = getStream(Random_t::Edge, from, to);
+  return stream.uniform() * config->max_weight;
+}
+
+/**
+ * @brief Random delay for a new edge.
+ *
+ * The second draw of the edge's stream.
+ *
+ * @param from global index of the presynaptic Neuron
+ * @param to global index of the postsynaptic Neuron
+ */
+int SNN::randomSynapseDelay(uint32_t from, uint32_t to) {
+  RandomStream stream = getStream(Random_t::Edge, from, to);
+  stream.discard(1);
+  int delay = stream.below(config->max_synapse_delay) +
+              config->min_synapse_delay;
+  return delay;
+}
+
+/**
+ * @brief Get the network ready to run.
+ *
+ * Freezes SNN::graph so edges added since the last run are visible to
+ * NeuronGroup::propagate, links the groups it connects (SNN::linkGroups) and
+ * rebuilds SNN::decay_table if RuntimConfig::TAU or the stimulus length
+ * changed
+ *
+ */
+void SNN::prepareRun() {
+  graph.freeze();
+  linkGroups();
+
+  int max_steps = DecayTable::steps(0, config->time_per_stimulus +
+                                           config->max_synapse_delay) +
+                  1;
+  if (decay_table.getTau() != config->TAU || decay_table.size() <= max_steps) {
+    decay_table.build(config->TAU, max_steps);
+  }
+}
+
+/**
+ * @brief Link every pair of groups SNN::graph has an edge between.
+ *
+ * Each link gets its own SpscRing and the smallest delay of its edges as
+ * lookahead (see NeuronGroup::runMultithread). A group publishes a tick before
+ * the messages it sends in that tick arrive, so an intergroup edge with a delay
+ * below 1 would have its messages run late. Such edges are rejected. Also
+ * resets every group's published timestamp.
+ *
+ * @throws std::runtime_error for an intergroup edge with a delay below 1
+ */
+void SNN::linkGroups() {
+  size_t n = groups.size();
+  for (auto group : groups) {
+    group->clearLinks(n);
+    group->updateTimestamp(0);
+  }
+  if (n == 1) {
+    return;
+  }
+
+  // smallest delay from group `from` into group `to`, -1 without edges
+  std::vector<int> lookahead(n * n, -1);
+  for (uint32_t node = 0; node < graph.nodeCount(); node++) {
+    size_t from = graph.getGroup(node)->getID() - 1;
+    for (uint32_t e = graph.edgesBegin(node); e < graph.edgesEnd(node); e++) {
+      size_t to = graph.getGroup(graph.getTarget(e))->getID() - 1;
+      if (from == to) {
+        continue;
+      }
+      if (graph.getDelay(e) < 1) {
+        lg->value(ERROR,
+                  "SNN::linkGroups: intergroup synapse from neuron %d has a "
+                  "delay below 1",
+                  static_cast<int>(node));
+        throw std::runtime_error("intergroup synapse with a delay below 1");
+      }
+      int &delay = lookahead[from * n + to];
+      if (delay < 0 || graph.getDelay(e) < delay) {
+        delay = graph.getDelay(e);
+      }
+    }
+  }
+
+  for (size_t to = 0; to < n; to++) {
+    for (size_t from = 0; from < n; from++) {
+      int delay = lookahead[from * n + to];
+      if (delay > 0) {
+        groups[to]->addInbound(groups[from], delay);
+      }
+    }
+  }
 }
 
 /**
@@ -346,16 +463,16 @@ void SNN::generateRandomSynapsesAdjMatrixGS() {
                                     intragroup_formed);
 
   if (intergroup_edges > 0) {
-    std::uniform_int_distribution<> group(0, groups.size() - 1);
+    RandomStream stream = getStream(Random_t::Intergroup);
     int intergroup_formed = 0;
     while (intergroup_formed < intergroup_edges) {
-      vecSz from = group(gen);
-      vecSz to = group(gen);
+      vecSz from = stream.below(groups.size());
+      vecSz to = stream.below(groups.size());
       if (from == to) {
         continue;
       }
-      auto origin = groups[from]->getRandNeuron();
-      auto destination = groups[to]->getNonInputNeuron();
+      auto origin = groups[from]->getRandNeuron(stream);
+      auto destination = groups[to]->getNonInputNeuron(stream);
       origin->addIGNeighbor(destination);
 
       // increment intergroup edges
@@ -404,10 +521,11 @@ void SNN::generateRandomSynapsesAdjMatrix() {
     mat.at(i) = std::vector<int>(non_input_count);
   }
 
+  RandomStream stream = getStream(Random_t::Synapses);
   int number_connections = 0;
   while (number_connections < config->NUMBER_EDGES) {
-    Matrix::size_type row = rand() % config->NUMBER_NEURONS;
-    Matrix::size_type col = rand() % non_input_count;
+    Matrix::size_type row = stream.below(config->NUMBER_NEURONS);
+    Matrix::size_type col = stream.below(non_input_count);
 
     if (mat.at(row).at(col) || row == col) {
       continue;
@@ -463,6 +581,7 @@ void SNN::generateRandomSynapses() {
   std::unordered_map<Neuron *, std::list<Neuron *>> map;
   generateNeighborOptions(map);
 
+  RandomStream stream = getStream(Random_t::Synapses);
   float progress = 0.0;
   int pos = 0;
   while (synapses_formed < config->NUMBER_EDGES) {
@@ -492,7 +611,7 @@ void SNN::generateRandomSynapses() {
 
       // get a random neuron in this list
       auto target = neighbor_options.begin();
-      std::advance(target, rand() % neighbor_options.size());
+      std::advance(target, stream.below(neighbor_options.size()));
 
       // get the neighbor_options for the postsynaptic neuron and an iter to
       // this neuron
@@ -543,7 +662,6 @@ void SNN::reset() {
   for (auto group : groups) {
     group->reset();
   }
-  gen.seed(config->RAND_SEED);
 }
 
 /**
@@ -566,7 +684,14 @@ void SNN::batchReset() {
   config->STIMULUS = config->STIMULUS_VEC.end();
 }
 
-void SNN::runChildProcess(const std::vector<int> &stimulus, int fd) {
+/**
+ * @brief Run a batch of stimuli in a forked child and exit.
+ *
+ * @param stimulus lines of the batch
+ * @param region where the activations go, see Log::writeToRegion
+ */
+void SNN::runChildProcess(const std::vector<int> &stimulus,
+                          ResultRegion &region) {
   // lg->value(LogLevel::INFO, "Child process running, PID: %d",
   //           static_cast<int>(getpid()));
   config->STIMULUS = stimulus.begin();
@@ -575,6 +700,7 @@ void SNN::runChildProcess(const std::vector<int> &stimulus, int fd) {
   config->num_stimulus = stimulus.size();
   inputFileReader->setToLine(*config->STIMULUS);
   setNextStim();
+  reset();
   generateInputNeuronEvents();
 
   for (int i = 1; i < config->num_stimulus + 1; i++) {
@@ -593,14 +719,23 @@ void SNN::runChildProcess(const std::vector<int> &stimulus, int fd) {
       generateInputNeuronEvents();
     }
   }
-  lg->writeToFD(fd, groups);
-  exit(EXIT_SUCCESS);
+  exit(lg->writeToRegion(region, groups) ? EXIT_SUCCESS : EXIT_FAILURE);
 }
 
+/**
+ * @brief Run every batch in its own forked child.
+ *
+ * Each child gets a ResultRegion, created right before it is forked, to write
+ * its activations to, SNN::forkRead collects them once the children exit. A
+ * batch whose region or fork fails is not run.
+ *
+ * @param stimulusBatches lines of each batch
+ */
 void SNN::forkRun(const std::vector<std::vector<int>> &stimulusBatches) {
+  prepareRun();
   config->STIMULUS_VEC.clear();
   std::vector<pid_t> children;
-  std::vector<int *> pipes;
+  std::vector<ResultRegion *> regions;
 
   // All the stimulus "lines" get inserted into the stimulus vector
   // for the following reason:
@@ -614,16 +749,19 @@ void SNN::forkRun(const std::vector<std::vector<int>> &stimulusBatches) {
     config->STIMULUS_VEC.insert(config->STIMULUS_VEC.end(),
                                 stimulusBatches.at(i).begin(),
                                 stimulusBatches.at(i).end());
-    int *pipefd = (int *)malloc(sizeof(int) * 2);
-    int r = pipe(pipefd);
-    if (r == -1) {
-      lg->log(LogLevel::ERROR, "SNN::forkRun: pipe failed to create pipe "
-                               "file descriptors, pipe() returned -1");
-      lg->string(LogLevel::ERROR, "erno reports %s", strerror(errno));
-    }
-    pipes.push_back(pipefd);
   }
   for (size_t i = 0; i < stimulusBatches.size(); i++) {
+    ResultRegion *region = new ResultRegion;
+    if (!region->create("snn-results")) {
+      lg->value(LogLevel::ERROR,
+                "SNN::forkRun: failed to create result region, "
+                "memfd_create() returned -1, batch with first stimulus of "
+                "line %d NOT run",
+                stimulusBatches.at(i).front());
+      lg->string(LogLevel::ERROR, "erno reports %s", strerror(errno));
+      delete region;
+      continue;
+    }
     pid_t cPID = fork();
     switch (cPID) {
     case -1: // error state
@@ -632,67 +770,139 @@ void SNN::forkRun(const std::vector<std::vector<int>> &stimulusBatches) {
                 "returned -1, batch with first stimulus of line %d NOT run",
                 stimulusBatches.at(i).front());
       lg->string(LogLevel::ERROR, "erno reports %s", strerror(errno));
+      delete region;
       break;
-    case 0: {                    // child process
-      int *pipefd = pipes.at(i); // get the corresponding pipe array
-      close(pipefd[0]);          // close the read end
-      runChildProcess(stimulusBatches.at(i), pipefd[1]);
+    case 0: // child process
+      for (ResultRegion *other : regions) {
+        other->close();
+      }
+      runChildProcess(stimulusBatches.at(i), *region);
       break;
-    }
     default: // parent process
+      regions.push_back(region);
       children.push_back(cPID);
       break;
     }
   }
   auto start = std::chrono::high_resolution_clock::now();
-  forkRead(children, pipes);
+  forkRead(children, regions);
   auto end = std::chrono::high_resolution_clock::now();
   std::chrono::duration<double> elapsed = end - start;
   std::cout << "forkread time elapsed is " << elapsed.count() << "\n";
 }
 
-void setNonBlocking(int fd) {
-  int flags = fcntl(fd, F_GETFL, 0);
-  fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+/**
+ * @brief Open a pidfd for `pid`, readable once it exits.
+ *
+ * @return -1 if the kernel has no pidfd_open
+ */
+static int openPidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+  return syscall(SYS_pidfd_open, pid, 0);
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
 }
 
-void SNN::forkRead(std::vector<pid_t> &childrenPIDs,
-                   std::vector<int *> &pipes) {
-  bool done = false;
-  for (auto pipefd : pipes) {
-    setNonBlocking(pipefd[0]);
-    close(pipefd[1]); // close write pipe
-  }
-
-  while (!done) {
-    for (size_t i = 0; i < childrenPIDs.size(); i++) {
-      // Ignore completed processes
-      pid_t cPID = childrenPIDs.at(i);
-      if (cPID == -1) {
-        continue;
-      }
+/**
+ * @brief Reap an exited child and add its ResultRegion to the Log.
+ *
+ * @param start when collection started, for the wall time reported
+ */
+static void collectChild(Log *lg, pid_t cPID, ResultRegion *region,
+                         hr_clock::time_point start) {
+  int wstatus;
+  waitpid(cPID, &wstatus, 0);
+  duration elapsed = hr_clock::now() - start;
+
+  size_t count = 0;
+  if (region->isOpen() && region->map()) {
+    count = region->count();
+    lg->addSpikes(region->records(), count);
+  } else {
+    lg->value(LogLevel::ERROR, "SNN::forkRead: child %d left no results",
+              static_cast<int>(cPID));
+  }
+  region->close();
 
-      int *pipefd = pipes.at(i); // get corresponding pipe
-      // LogData4_t buf;
-      LogData buf;
+  std::string msg = "SNN::forkRead: child " + std::to_string(cPID) +
+                    " done after " + std::to_string(elapsed.count()) +
+                    " seconds, " + std::to_string(count) + " activations";
+  lg->log(LogLevel::INFO, msg.c_str());
+}
 
-      while (read(pipefd[0], &buf, sizeof(LogData)) > 0) {
-        LogData *toAdd = new LogData(buf);
-        lg->addData(toAdd);
-      }
+/**
+ * @brief Wait for every child and add what it wrote to the Log.
+ *
+ * Sleeps in epoll on a pidfd per child and collects each child as soon as it
+ * exits, the parent takes no CPU time from the children meanwhile. Without
+ * pidfd support the children are waited for one after another instead. A
+ * failed fork is marked with a pid of -1, its region is skipped.
+ *
+ * @param childrenPIDs one per region
+ * @param regions freed once read
+ */
+void SNN::forkRead(std::vector<pid_t> &childrenPIDs,
+                   std::vector<ResultRegion *> &regions) {
+  hr_clock::time_point start = hr_clock::now();
+  int epfd = epoll_create1(EPOLL_CLOEXEC);
+  std::vector<int> pidfds(childrenPIDs.size(), -1);
+  size_t waiting = 0;
+
+  for (size_t i = 0; i < childrenPIDs.size(); i++) {
+    if (childrenPIDs.at(i) == -1 || epfd == -1) {
+      continue;
+    }
+    int pidfd = openPidfd(childrenPIDs.at(i));
+    if (pidfd == -1) {
+      continue;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = i;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, pidfd, &event) == -1) {
+      close(pidfd);
+      continue;
+    }
+    pidfds.at(i) = pidfd;
+    waiting++;
+  }
 
-      int wstatus;
-      if (waitpid(cPID, &wstatus, WNOHANG)) {
-        close(pipefd[0]);
-        childrenPIDs.at(i) = -1;
+  epoll_event events[64];
+  while (waiting) {
+    int ready = epoll_wait(epfd, events, 64, -1);
+    if (ready == -1) {
+      if (errno == EINTR) {
+        continue;
       }
+      lg->string(LogLevel::ERROR, "SNN::forkRead: epoll_wait failed, %s",
+                 strerror(errno));
+      break;
+    }
+    for (int e = 0; e < ready; e++) {
+      size_t i = events[e].data.u64;
+      collectChild(lg, childrenPIDs.at(i), regions.at(i), start);
+      epoll_ctl(epfd, EPOLL_CTL_DEL, pidfds.at(i), nullptr);
+      close(pidfds.at(i));
+      pidfds.at(i) = -1;
+      childrenPIDs.at(i) = -1;
+      waiting--;
     }
-    done = std::all_of(childrenPIDs.begin(), childrenPIDs.end(),
-                       [](pid_t x) { return x == -1; });
   }
 
-  for (auto pPipeArr : pipes) {
-    free(pPipeArr);
+  // children without a pidfd, or left over if epoll failed
+  for (size_t i = 0; i < childrenPIDs.size(); i++) {
+    if (childrenPIDs.at(i) != -1) {
+      collectChild(lg, childrenPIDs.at(i), regions.at(i), start);
+    }
+    if (pidfds.at(i) != -1) {
+      close(pidfds.at(i));
+    }
+    delete regions.at(i);
+  }
+  if (epfd != -1) {
+    close(epfd);
   }
 }
 
@@ -701,12 +911,25 @@ void SNN::forkRead(std::vector<pid_t> &childrenPIDs,
  *
  * Set stimulus values of all `InputNeuron`s and starts threads for
  * each NeuronGroup. Cycle through each stimulus, reseting the NeuronGroup after
- * stimulus.
+ * stimulus. With RuntimConfig::workers other than 1 every stimulus is read up
+ * front and run by SNN::runPool instead.
  *
  */
 void SNN::start() {
 
+  prepareRun();
+  if (config->workers != 1) {
+    std::vector<std::vector<double>> inputs(
+        config->STIMULUS_VEC.size(), std::vector<double>(input_neurons.size()));
+    for (auto &input : inputs) {
+      inputFileReader->nextStimulus(input);
+    }
+    runPool(InputMatrix(inputs));
+    return;
+  }
+
   setNextStim();
+  reset();
   generateInputNeuronEvents();
   lg->value(LogLevel::INFO, "InputNeuronEvents Generated, size %d",
             config->INPUT_PROB_SUCCESS * config->time_per_stimulus);
@@ -744,6 +967,7 @@ void SNN::start() {
     }
     for (auto group : groups) {
       pthread_join(group->getThreadID(), NULL);
+      group->transferData();
     }
     if (i < config->num_stimulus) {
       config->STIMULUS++;
@@ -758,11 +982,47 @@ void SNN::start() {
                 config->INPUT_PROB_SUCCESS * config->time_per_stimulus);
     }
   }
-  for (auto group : groups) {
-    for (auto n : group->getMutNeuronVec()) {
-      n->transferData();
-    }
+}
+
+/**
+ * @brief Count activations in `histogram` as they happen.
+ *
+ * Rows of the histogram are stimulus numbers. Replaces the previous
+ * histogram, if any, pass nullptr to stop counting. Set before forking for
+ * forked children to count into it as well.
+ *
+ * @param histogram counts, shared with whoever reads them
+ * @param keep_spikes whether activations are logged as well
+ */
+void SNN::setHistogram(std::shared_ptr<ActivationHistogram> histogram,
+                       bool keep_spikes) {
+  this->histogram = histogram;
+  this->keep_spikes = histogram ? keep_spikes : true;
+}
+
+/**
+ * @brief Run every stimulus of RuntimConfig::STIMULUS_VEC in a StimulusPool.
+ *
+ * The pool is kept between calls and rebuilt only when RuntimConfig::workers
+ * changes. Activations end up in the Log like with SNN::start.
+ *
+ * @param inputs value of every InputNeuron per stimulus, in the order of
+ * RuntimConfig::STIMULUS_VEC
+ */
+void SNN::runPool(const InputMatrix &inputs) {
+  int workers = config->workers;
+  if (workers <= 0) {
+    workers = sysconf(_SC_NPROCESSORS_ONLN);
   }
+  if (pool && pool->size() != workers) {
+    delete pool;
+    pool = nullptr;
+  }
+  if (!pool) {
+    lg->value(INFO, "Starting %d stimulus workers", workers);
+    pool = new StimulusPool(this, workers);
+  }
+  pool->run(config->STIMULUS_VEC, inputs);
 }
 
 /**
@@ -775,16 +1035,10 @@ void SNN::setNextStim() {
     return;
   }
 
-  std::string line = inputFileReader->nextLine();
-
-  std::stringstream s(line);
-  long double value;
-  char discard;
-
-  for (InputNeuron *input_neuron : input_neurons) {
-    s >> value >> discard;
-    long double set = value;
-    input_neuron->setInputValue(set);
+  std::vector<double> values(input_neurons.size());
+  inputFileReader->nextStimulus(values);
+  for (size_t i = 0; i < input_neurons.size(); i++) {
+    input_neurons[i]->setInputValue(values[i]);
   }
 }
 
@@ -848,14 +1102,16 @@ std::string generate_neuron_string(Neuron *n) {
  *
  */
 void SNN::generateGraphiz(bool weights) {
+  prepareRun();
   std::ofstream file("network.dot");
   file << "digraph {\n";
   if (!weights) {
     for (auto n : neurons) {
       std::string fstr = generate_neuron_string(n);
       std::vector<std::string> to;
-      for (auto s : n->getPostSynaptic()) {
-        to.push_back(generate_neuron_string(s->getPostSynaptic()));
+      uint32_t node = n->getGlobalIndex();
+      for (uint32_t e = graph.edgesBegin(node); e < graph.edgesEnd(node); e++) {
+        to.push_back(generate_neuron_string(neurons[graph.getTarget(e)]));
       }
 
       if (n->getType() == Neuron_t::Input) {
@@ -876,10 +1132,11 @@ void SNN::generateGraphiz(bool weights) {
         file << fstr << " [fontcolor=green]\n";
       }
 
-      for (auto t : n->getPostSynaptic()) {
-        std::string tstr = generate_neuron_string(t->getPostSynaptic());
+      uint32_t node = n->getGlobalIndex();
+      for (uint32_t e = graph.edgesBegin(node); e < graph.edgesEnd(node); e++) {
+        std::string tstr = generate_neuron_string(neurons[graph.getTarget(e)]);
         file << fstr << " -> " << tstr << " [label= " << std::setprecision(3)
-             << t->getWeight() << " ]\n";
+             << graph.getWeight(e) << " ]\n";
       }
     }
   }
@@ -903,44 +1160,58 @@ void SNN::generateGraphiz(bool weights) {
  *
  * Stimulus 2: all InputNeuron recieve something like
  * { 2, 3, 6, 9}
+ *
+ * Every group queues a single Message per timestamp that runs all of its
+ * InputNeuron, see NeuronGroup::queueStimulus.
  */
 void SNN::generateInputNeuronEvents() {
 
-  int num_events = config->INPUT_PROB_SUCCESS * config->time_per_stimulus;
-
-  std::vector<int> timestamps(num_events);
+  std::vector<int> timestamps = stimulusTimestamps(*config->STIMULUS);
 
-  for (int i = 0; i < num_events; i++) {
-    timestamps.at(i) = std::abs(getRandom()) % config->time_per_stimulus;
+  for (auto group : groups) {
+    group->clearStimulus();
   }
-
   for (auto in : input_neurons) {
     if (in->getInputValue() < 0.00001) {
       continue;
     }
-    in->generateEvents(timestamps);
+    in->joinStimulus();
+  }
+  for (auto group : groups) {
+    group->queueStimulus(timestamps);
   }
 }
 
+/**
+ * @brief Input timestamps of a stimulus.
+ *
+ * INPUT_PROB_SUCCESS * time_per_stimulus draws from the stream of `stimulus`,
+ * so a stimulus gets the same timestamps in SNN::generateInputNeuronEvents,
+ * a StimulusPool worker or a forked child.
+ *
+ * @param stimulus line of the stimulus in the input
+ */
+std::vector<int> SNN::stimulusTimestamps(int stimulus) {
+  int num_events = config->INPUT_PROB_SUCCESS * config->time_per_stimulus;
+  RandomStream stream = getStream(Random_t::Timestamps, stimulus);
+
+  std::vector<int> timestamps(num_events);
+  for (int i = 0; i < num_events; i++) {
+    timestamps.at(i) = stream.below(config->time_per_stimulus);
+  }
+  return timestamps;
+}
+
 int SNN::generateCSV() {
   std::sort(config->STIMULUS_VEC.begin(), config->STIMULUS_VEC.end());
   int max_stim = config->STIMULUS_VEC.back();
   int min_stim = config->STIMULUS_VEC.front();
   int totalActivations = 0;
 
-  std::unordered_map<int, std::vector<LogData *>> stim_data;
-  const std::vector<LogData *> &lg_data = lg->getLogData();
-
-  for (std::vector<LogData *>::size_type i = 0; i < lg_data.size(); i++) {
-    LogData *td = lg_data.at(i);
-    if (td->message_type == Message_t::Refractory) {
-      totalActivations++;
-      if (stim_data.find(td->stimulus_number) != stim_data.end()) {
-        stim_data[td->stimulus_number].push_back(td);
-      } else {
-        stim_data[td->stimulus_number] = {td};
-      }
-    }
+  std::unordered_map<int, std::vector<int>> stim_data;
+  for (const SpikeRecord &spike : lg->getSpikes()) {
+    totalActivations++;
+    stim_data[spike.stimulus].push_back(spike.timestamp);
   }
 
   int bins = config->time_per_stimulus;
@@ -952,21 +1223,18 @@ int SNN::generateCSV() {
       ret.at(s - min_stim) = std::vector<int>(bins, 0);
       continue;
     }
-    std::vector<LogData *> &sd = stim_data[s];
+    std::vector<int> &sd = stim_data[s];
 
-    std::sort(sd.begin(), sd.end(), [](LogData *a, LogData *b) {
-      return a->timestamp < b->timestamp;
-    });
+    std::sort(sd.begin(), sd.end());
 
-    double timestep =
-        (double)(sd.back()->timestamp - sd.front()->timestamp) / bins;
-    double l = sd.front()->timestamp;
+    double timestep = (double)(sd.back() - sd.front()) / bins;
+    double l = sd.front();
     double u = l + timestep;
 
     std::vector<int> row(bins);
     for (int i = 0; i < bins; i++) {
-      row.at(i) = std::count_if(sd.begin(), sd.end(), [l, u](LogData *ld) {
-        return (ld->timestamp < u) && (ld->timestamp >= l);
+      row.at(i) = std::count_if(sd.begin(), sd.end(), [l, u](int timestamp) {
+        return (timestamp < u) && (timestamp >= l);
       });
       l = u;
       u = u + timestep;
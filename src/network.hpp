@@ -1,18 +1,25 @@
 #ifndef NETWORK
 #define NETWORK
+#include "decay_table.hpp"
 #include "file_reader.hpp"
+#include "input_matrix.hpp"
 #include "input_neuron.hpp"
+#include "random_stream.hpp"
 #include "stimulus.hpp"
+#include "synapse_graph.hpp"
 #include <climits>
 #include <cmath>
 #include <list>
-#include <random>
+#include <memory>
 #include <stdexcept>
 #include <unordered_map>
 #include <vector>
 
 class Neuron;
 class NeuronGroup;
+class ActivationHistogram;
+class ResultRegion;
+class StimulusPool;
 struct RuntimConfig;
 struct Mutex;
 
@@ -51,8 +58,11 @@ protected:
   Barrier *barrier;
   Image *image;
   InputFileReader *inputFileReader;
-  std::mt19937 gen;
-  std::random_device rd;
+  SynapseGraph graph; /**< Edges between all `Neuron`s in SNN::neurons */
+  DecayTable decay_table;
+  StimulusPool *pool = nullptr; /**< created by SNN::runPool */
+  std::shared_ptr<ActivationHistogram> histogram; /**< see SNN::setHistogram */
+  bool keep_spikes = true;
 
 public:
   Log *lg;
@@ -69,6 +79,8 @@ public:
                           AdjListParser::AdjListInfo &info);
   void generateSynapsesFromAdjList(const AdjListParser::AdjList &adjList);
   void setInputNeuronLatency();
+  double randomSynapseWeight(uint32_t from, uint32_t to);
+  int randomSynapseDelay(uint32_t from, uint32_t to);
 
   // In-house synapse generation algorithms
   void generateRandomSynapses();
@@ -83,15 +95,18 @@ public:
   void generateNonInputNeuronVec();
   void generateInputNeuronVec();
   void generateInputNeuronEvents();
+  std::vector<int> stimulusTimestamps(int stimulus);
 
   // runtime operations
+  void prepareRun();
+  void linkGroups();
   void setNextStim();
   void forkRun(const std::vector<std::vector<int>> &stimulusSets);
-  void forkRead(std::vector<pid_t> &childrenPIDs, std::vector<int *> &pipes);
-  void forkReadSmall(std::vector<pid_t> &childrenPIDs,
-                     std::vector<int *> &pipes);
-  void runChildProcess(const std::vector<int> &stimulus, int fd);
+  void forkRead(std::vector<pid_t> &childrenPIDs,
+                std::vector<ResultRegion *> &regions);
+  void runChildProcess(const std::vector<int> &stimulus, ResultRegion &region);
   void start();
+  void runPool(const InputMatrix &inputs);
   void join();
   void reset();
   void batchReset();
@@ -106,11 +121,19 @@ public:
   pthread_cond_t *getSwitchCond() { return &stimulus_switch_cond; }
   static int maximum_edges(int num_i, int num_n);
   std::vector<InputNeuron *> &getMutInputNeurons() { return input_neurons; }
+  const std::vector<Neuron *> &getNeurons() const { return neurons; }
+  void setHistogram(std::shared_ptr<ActivationHistogram> histogram,
+                    bool keep_spikes = true);
+  ActivationHistogram *getHistogram() const { return histogram.get(); }
+  bool keepsSpikes() const { return keep_spikes; }
+  const std::vector<NeuronGroup *> &getGroups() const { return groups; }
+  SynapseGraph &getGraph() { return graph; }
+  const DecayTable &getDecayTable() const { return decay_table; }
   RuntimConfig *getConfig() { return config; }
   Mutex *getMutex() { return mutex; }
   Barrier *getBarrier() { return barrier; }
   Image *getImage() { return image; }
-  int getRandom() { return gen(); }
-  std::mt19937 &getGen() { return gen; }
+  RandomStream getStream(Random_t purpose, uint32_t a = 0, uint32_t b = 0,
+                         uint32_t c = 0);
 };
 #endif // !NETWORK
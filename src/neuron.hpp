@@ -4,50 +4,32 @@
 #include "log.hpp"
 #include "message.hpp"
 #include "neuron_group.hpp"
-#include "synapse.hpp"
 #include <iostream>
-#include <list>
 #include <pthread.h>
 #include <unistd.h>
 
 using std::cout;
-using std::list;
 
 class NeuronGroup;
 
 enum Neuron_t { None = 0, Input = 1 };
 
+/**
+ * @brief A Neuron and its connections.
+ *
+ * The dynamic state (membrane potential, timestamps and thresholds) lives in
+ * the owning NeuronGroup's NeuronState at Neuron::index and its outgoing
+ * edges in the SNN's SynapseGraph, Neuron only provides a view on them.
+ */
 class Neuron {
 protected:
-  vector<LogData *> log_data;
 
   // Neuron vaules
-  double membrane_potential; /**< Membrane potential of a Neuron */
   int excit_inhib_value;
   int id;
+  uint32_t index; /**< Position in NeuronGroup::getNeuronVec */
   Neuron_t type;
   NeuronGroup *group;
-  bool active = false;
-  int refractory_duration;
-  double activationThreshold;
-  double refractory_potential;
-
-  // timestamp data
-  int last_decay = -1; /**< The timestamp of the most recent decay */
-  int refractory_start =
-      0; /**< The timestamp of most recent refractory period start */
-  int last_fire = 0;
-
-  // Edge values
-  vector<Synapse *>
-      PostSynapticConnnections; /**< vector of Synapse pointers to which this
-                                   Neuron is connected */
-  vector<Synapse *>
-      PreSynapticConnections; /**< vector of Synapse pointers from which this
-                                 Neuron has Connections */
-
-  // message list
-  list<Message *> messages; /**< list of Message pointers  */
 
 public:
   Neuron(int _id, NeuronGroup *group, Neuron_t type);
@@ -56,60 +38,21 @@ public:
   void addNeighbor(Neuron *neighbor, double weight = -1,
                    double synapseDelay = -1);
   void addIGNeighbor(Neuron *neighbor);
-  void addPostSynapticConnection(Synapse *synapse);
-  void addPreSynapticConnection(Synapse *synapse);
-
-  // Running and messaging
-  virtual void run(Message *message);
-  virtual void sendMessages();
-
-  int recieveMessage();
-  void addMessage(Message *);
-  Message *retrieveMessage();
-  const vector<Synapse *> &getSynapses() const;
-
-  // State operations
-  virtual void reset();
-  void refractory();
-  void setType(Neuron_t type);
-  void activate();
-  void deactivate();
-  void retroactiveDecay(int from, int to);
-  void accumulatePotential(double value);
-  int generateInhibitoryStatus();
 
   // GETTERS
-  bool isActivated() const;
-
-  double getPotential() const;
   NeuronGroup *getGroup() const;
-
-  const list<Message *> &getMessageVector() const;
-  const vector<Synapse *> &getPostSynaptic() const;
-  const vector<Synapse *> &getPresynaptic() const;
-  const vector<LogData *> &getLogData() const;
-
-  int getLastDecay() const;
-  int getLastFire() const;
+  int getRefractoryStart() const;
   int getBias() const;
   Neuron_t getType() const;
   int getID() const;
+  uint32_t getIndex() const { return index; }
+  uint32_t getGlobalIndex() const;
+  void setIndex(uint32_t i) { index = i; }
 
   // Mutators
-  void setRefractoryDuration(double refractoryDuration) {
-    refractory_duration = refractoryDuration;
-  }
-  void setRefractoryMembranePotential(double refractoryMembranePotential) {
-    refractory_potential = refractoryMembranePotential;
-  }
-  void setActivationThreshold(double activation_threshold) {
-    activationThreshold = activation_threshold;
-  }
-
-  // log operations
-  void addData(int time, Message_t message_type);
-  LogDataArray getRefractoryArray();
-  void transferData();
+  void setRefractoryDuration(double refractoryDuration);
+  void setRefractoryMembranePotential(double refractoryMembranePotential);
+  void setActivationThreshold(double activation_threshold);
 };
 
 #endif // !NEURON
@@ -1,11 +1,14 @@
+#include "activation_histogram.hpp"
 #include "input_neuron.hpp"
 #include "log.hpp"
 #include "network.hpp"
 #include "neuron.hpp"
 #include "runtime.hpp"
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <pthread.h>
-#include <random>
+#include <sched.h>
 #include <unistd.h>
 
 /**
@@ -17,21 +20,27 @@
  */
 NeuronGroup::NeuronGroup(int _id, int number_neurons, int number_input_neurons,
                          SNN *network)
-    : id(_id), most_recent_timestamp(0), network(network) {
+    : id(_id), most_recent_timestamp(0), network(network), engine(this) {
   getNetwork()->lg->state(DEBUG, "Adding Group %d", _id);
+
+  // one bucket per tick a stimulus can produce
+  message_q.reserve(network->getConfig()->time_per_stimulus +
+                    network->getConfig()->max_synapse_delay + 1);
   getNetwork()->lg->state(DEBUG, "Group %d", id);
 
   number_neurons -= number_input_neurons;
   getNetwork()->lg->value(DEBUG4, "number_neurons is %d", number_neurons);
+  RandomStream stream = network->getStream(Random_t::Layout, _id);
   int id = 1;
   while (number_neurons || number_input_neurons) {
 
     // 1 is regular, 0 is input
-    int roll = rand() % 2;
+    int roll = stream.below(2);
 
     if (roll && number_neurons) {
 
       Neuron *neuron = new Neuron(id, this, Neuron_t::None);
+      neuron->setIndex(all_neurons.size());
       all_neurons.push_back(neuron);
       nI_neurons.push_back(neuron);
       number_neurons--;
@@ -39,22 +48,54 @@ NeuronGroup::NeuronGroup(int _id, int number_neurons, int number_input_neurons,
 
     } else if (!roll && number_input_neurons) {
       InputNeuron *neuron = new InputNeuron(id, this, 0);
+      neuron->setIndex(all_neurons.size());
       all_neurons.push_back(neuron);
       input_neurons.push_back(neuron);
       number_input_neurons--;
       id++;
     }
   }
+
+  RuntimConfig *config = network->getConfig();
+  state.assign(all_neurons.size(), config->INITIAL_MEMBRANE_POTENTIAL,
+               config->ACTIVATION_THRESHOLD, config->REFRACTORY_DURATION,
+               config->REFRACTORY_MEMBRANE_POTENTIAL);
+}
+
+/**
+ * @brief Replica of a NeuronGroup.
+ *
+ * Shares the `Neuron`s of `prototype` and owns a copy of its NeuronState, its
+ * own message queue and TickEngine, so one stimulus can run on it while other
+ * replicas of the same network run theirs. Messages to other groups go to the
+ * matching group of `replica`. Activations are logged with the stimulus set by
+ * NeuronGroup::setStimulus.
+ *
+ * @param prototype group to replicate
+ * @param replica every group of the replica, by group ID - 1
+ */
+NeuronGroup::NeuronGroup(NeuronGroup *prototype,
+                         const std::vector<NeuronGroup *> *replica)
+    : all_neurons(prototype->all_neurons), nI_neurons(prototype->nI_neurons),
+      input_neurons(prototype->input_neurons), state(prototype->state),
+      offset(prototype->offset), id(prototype->id), most_recent_timestamp(0),
+      network(prototype->network), engine(this), prototype(prototype),
+      replica(replica) {
+  message_q.reserve(network->getConfig()->time_per_stimulus +
+                    network->getConfig()->max_synapse_delay + 1);
 }
 
 /**
  * @brief Destructs NeuronGroup.
  *
  * NeuronGroup holds memory responsibility for `Neuron`s and deallocates them in
- * its destructor
+ * its destructor, a replica leaves them to its prototype
  *
  */
 NeuronGroup::~NeuronGroup() {
+  if (prototype) {
+    return;
+  }
   for (auto neuron : all_neurons) {
 
     getNetwork()->lg->groupNeuronState(DEBUG, "Deleteing Group %d Neuron %d",
@@ -64,156 +105,330 @@ NeuronGroup::~NeuronGroup() {
       delete neuron;
       neuron = nullptr;
     }
-
-    pthread_mutex_destroy(&limit_tex);
-    pthread_mutex_destroy(&time_stamp_tex);
-    pthread_cond_destroy(&limit_cond);
   }
+  clearLinks(0);
 }
 
+/**
+ * @brief Run cycle for a group running alongside others.
+ *
+ * Conservative synchronization without locks. Every group publishes its
+ * current tick in NeuronGroup::most_recent_timestamp, and a Message sent over
+ * an intergroup link arrives at least the link's lookahead (its smallest
+ * synapse delay) later. Every tick before NeuronGroup::safeBound is therefore
+ * complete once the inbound rings are drained, and the whole window is run
+ * without waiting. When nothing is safe the group publishes how far it is
+ * known to be idle, which lets the groups it feeds advance, and yields.
+ *
+ * Nothing is sent past RuntimConfig::time_per_stimulus, so the group is done
+ * once its queue and its bound are past it.
+ */
 void NeuronGroup::runMultithread() {
 
   // Log running status
   getNetwork()->lg->state(DEBUG, "Group %d running", getID());
 
-  bool hasInterGroup = !interGroupConnections.empty();
-
-  pthread_mutex_lock(&message_q_tex);
-  bool empty = message_q.empty();
-  pthread_mutex_unlock(&message_q_tex);
-
-  // !DEBUG
-  size_t max = 0;
+  int horizon = network->getConfig()->time_per_stimulus + 1;
 
-  // Loop through all events in the message q
-  while (!empty) {
+  while (true) {
+    // read the bound before draining, anything sent below it is in a ring
+    int bound = safeBound();
+    drainInbound();
 
-    // !DEBUG
-    if (message_q.size() > max) {
-      max = message_q.size();
+    int next = message_q.empty() ? horizon : message_q.frontTime();
+    if (next >= bound) {
+      int idle = std::min(next, bound);
+      if (idle >= horizon) {
+        break;
+      }
+      updateTimestamp(idle);
+      sched_yield();
+      continue;
     }
 
-    // retrieve the top message in priority q
-    Message *message = getMessage();
-
-    // Error check for out of order events
-    if (message->timestamp < getTimestamp()) {
-      logUnseqMessage(message, getTimestamp());
+    // run the safe window
+    while (!message_q.empty() && message_q.frontTime() < bound) {
+      int timestamp = message_q.frontTime();
+      updateTimestamp(timestamp);
+      runTick(timestamp);
     }
+  }
 
-    // Update the timestamp to reflect the time this group is processing
-    updateTimestamp(message->timestamp);
-
-    // broadcast our condtion for any threads waiting on this
-    pthread_cond_broadcast(&limit_cond);
+  // Update our timestamp past the end of the stimulus to reflect that this
+  // group is finished
+  updateTimestamp(horizon);
+}
 
-    // Enter this loop if we have intergroup connections and therefore need to
-    // consider limiting groups
-    if (hasInterGroup) {
+void NeuronGroup::runSingleThread() {
+  // Log running status
+  // getNetwork()->lg->state(DEBUG, "Group %d running", getID());
 
-      // Find the limiting group (out of all our incoming connections, who has
-      // the smallest timestamp)
-      IGlimit limiter = findLimitingGroup();
+  bool empty = message_q.empty();
 
-      // Update the limiter and wait for their timestamp to equal to or larger
-      // than ours
-      while (limiter.timestamp < message->timestamp) {
+  // Loop through all events in the message q
+  while (!empty) {
 
-        // lock the mutex for the pthread_cond
-        pthread_mutex_lock(&limiter.limitingGroup->getLimitTex());
+    // retrieve the top message in priority q. The Message is copied out of
+    // the pool since running it may push new messages and grow the pool
+    Message message = message_pool.release(message_q.pop());
+    processed_messages++;
 
-        // Wrap the condition in a boolean while loop as suggested here:
-        // https://docs.oracle.com/cd/E19455-01/806-5257/6je9h032r/index.html
-        while (limiter.timestamp < message->timestamp) {
-          // DEBUG
-          network->lg->neuronInteraction(
-              INFO, "%d @ t-%d waiting on %d @ t-%d, ", id, message->timestamp,
-              limiter.limitingGroup->getID(), limiter.timestamp);
+    if (message.message_type == Message_t::Stimulus_Tick) {
+      runStimulusTick(message);
+    } else {
+      runNeuron(message);
+    }
 
-          // POTENTIALLY INCORRECT Broadcast our condition first to prevent
-          // groups waiting on eachother
-          pthread_cond_broadcast(&limit_cond);
+    // Update our empty bool
+    empty = message_q.empty();
+  }
+}
 
-          // Wait on the limter's condition
-          pthread_cond_wait(&limiter.getLimitCond(), &limiter.getLimitTex());
+/**
+ * @brief Clock driven run cycle of a single group, see TickEngine.
+ */
+void NeuronGroup::runClockDriven() {
+  while (!message_q.empty()) {
+    runTick(message_q.frontTime());
+  }
+}
 
-          // update the limiters timestamp and recheck our timestamps, entering
-          // this loop again if necessary
-          limiter.updateTimestamp();
+/**
+ * @brief Run every queued Message of the oldest tick.
+ *
+ * The event driven engine runs the messages one by one, including messages
+ * sent to the tick while it runs (delay 0). The clock driven engine drains the
+ * tick into a batch and integrates it with NeuronGroup::engine, messages sent
+ * to the tick meanwhile form the next batch.
+ *
+ * @param timestamp NeuronGroup::message_q.frontTime()
+ */
+void NeuronGroup::runTick(int timestamp) {
+  if (network->getConfig()->engine == Engine::ClockDriven) {
+    batch.clear();
+    while (!message_q.empty() && message_q.frontTime() == timestamp) {
+      Message message = message_pool.release(message_q.pop());
+      processed_messages++;
+      if (message.message_type != Message_t::Stimulus_Tick) {
+        batch.push_back(message);
+        continue;
+      }
+      // one lane message per input and draw, in the order runStimulusTick
+      // applies them
+      for (const StimulusInput &input : stimulus_inputs) {
+        if (timestamp < input.latency) {
+          continue;
+        }
+        for (uint32_t k = 0; k < message.target; k++) {
+          batch.push_back(
+              Message(input.value, input.index, Message_t::Stimulus, timestamp));
         }
-        pthread_mutex_unlock(&limiter.limitingGroup->getLimitTex());
-
-        // find the next limting group (potentially the same group)
-        limiter = findLimitingGroup();
       }
     }
+    engine.run(timestamp, batch);
+    return;
+  }
 
-    // run neuron on message
-    switch (message->post_synaptic_neuron->getType()) {
-    case Neuron_t::Input: {
-      InputNeuron *in =
-          dynamic_cast<InputNeuron *>(message->post_synaptic_neuron);
-      in->run(message);
-      break;
-    }
-    case Neuron_t::None: {
-      Neuron *n = message->post_synaptic_neuron;
-      n->run(message);
-      break;
+  while (!message_q.empty() && message_q.frontTime() == timestamp) {
+    Message message = getMessage();
+    processed_messages++;
+
+    // Error check for out of order events
+    if (message.timestamp < timestamp) {
+      logUnseqMessage(message, timestamp);
     }
+
+    if (message.message_type == Message_t::Stimulus_Tick) {
+      runStimulusTick(message);
+    } else {
+      runNeuron(message);
     }
+  }
+}
 
-    // Update our empty bool
-    pthread_mutex_lock(&message_q_tex);
-    empty = message_q.empty();
-    pthread_mutex_unlock(&message_q_tex);
+/**
+ * @brief Deliver a Message to its target Neuron.
+ *
+ * Ignores the message during the refractory period, otherwise decays and
+ * accumulates the target's membrane potential in NeuronGroup::state and sends
+ * messages to its neighbors if it is over its activation threshold.
+ *
+ * @param message Message for one of this group's `Neuron`s
+ */
+void NeuronGroup::runNeuron(const Message &message) {
+  uint32_t i = message.target;
+
+  // check refractory
+  if (message.timestamp <
+      state.refractory_start[i] + state.refractory_duration[i]) {
+    return;
   }
 
-  // // !DEBUG
-  // std::cout << "Max message_q size was: " << max << "\n";
+  retroactiveDecay(i, message.timestamp);
 
-  // Update our timestamp to the maximum possible time to reflect that this
-  // group is finished
-  updateTimestamp(network->getConfig()->time_per_stimulus +
-                  network->getConfig()->max_synapse_delay);
+  state.membrane_potential[i] += message.message;
 
-  // POTENTIALLY UNNECESSARY Broadcast our condition just in case
-  pthread_cond_broadcast(&limit_cond);
+  if (state.membrane_potential[i] >= state.activation_threshold[i]) {
+    state.last_fire[i] = message.timestamp;
+    fire(i);
+  }
 }
 
-void NeuronGroup::runSingleThread() {
-  // Log running status
-  // getNetwork()->lg->state(DEBUG, "Group %d running", getID());
+/**
+ * @brief Apply the current stimulus to every InputNeuron past its latency.
+ *
+ * Runs the InputNeuron, in NeuronGroup::stimulus_inputs order, as if it had
+ * been sent one Stimulus Message per draw of the tick.
+ *
+ * @param tick Message_t::Stimulus_Tick queued by NeuronGroup::queueStimulus
+ */
+void NeuronGroup::runStimulusTick(const Message &tick) {
+  for (const StimulusInput &input : stimulus_inputs) {
+    if (tick.timestamp < input.latency) {
+      continue;
+    }
+    Message message(input.value, input.index, Message_t::Stimulus,
+                    tick.timestamp);
+    for (uint32_t k = 0; k < tick.target; k++) {
+      runNeuron(message);
+    }
+  }
+}
 
-  bool empty = message_q.empty();
+/**
+ * @brief Send the messages of a spike and enter the refractory period.
+ *
+ * The spike happens at the Neuron's last fire. Its membrane potential is set
+ * to its refractory potential and the activation is logged.
+ *
+ * @param index Neuron::getIndex of the firing Neuron
+ */
+void NeuronGroup::fire(uint32_t index) {
+  propagate(index, state.membrane_potential[index]);
 
-  // Loop through all events in the message q
-  while (!empty) {
+  int refractory_start = state.refractory_start[index] =
+      state.last_fire[index];
+  state.membrane_potential[index] = state.refractory_potential[index];
+  addActivation(index, refractory_start);
+}
+
+/**
+ * @brief Queue the Messages of a spike.
+ *
+ * Walks the Neuron's slice of the SynapseGraph and sends a Message to the
+ * destination's NeuronGroup (NeuronGroup::deliver) for every edge whose delay
+ * does not take it past RuntimConfig::time_per_stimulus. The spike happens at
+ * the Neuron's last fire.
+ *
+ * @param index Neuron::getIndex of the firing Neuron
+ * @param potential membrane potential at the time of the spike
+ */
+void NeuronGroup::propagate(uint32_t index, double potential) {
+  const SynapseGraph &graph = network->getGraph();
+  int time_per_stimulus = network->getConfig()->time_per_stimulus;
+  int last_fire = state.last_fire[index];
+  int bias = all_neurons[index]->getBias();
+  potential = std::abs(potential);
+  uint32_t node = offset + index;
+
+  for (uint32_t e = graph.edgesBegin(node); e < graph.edgesEnd(node); e++) {
+    int timestamp = last_fire + graph.getDelay(e);
+    if (timestamp > time_per_stimulus) {
+      continue;
+    }
+    uint32_t target = graph.getTarget(e);
+    double message_value = potential * graph.getWeight(e) * bias;
+    deliver(graph.getGroup(target),
+            Message(message_value, graph.getIndex(target), From_Neighbor,
+                    timestamp, id));
+  }
+}
+
+/**
+ * @brief Log an activation of a Neuron.
+ *
+ * Counted in the SNN's ActivationHistogram, if it has one, and appended by
+ * value to NeuronGroup::activations, which only the thread running the group
+ * touches, unless the SNN keeps no spikes. A group logs the current stimulus,
+ * a replica the one set by NeuronGroup::setStimulus.
+ *
+ * @param index Neuron::getIndex of the Neuron
+ * @param time start of the refractory period
+ */
+void NeuronGroup::addActivation(uint32_t index, int time) {
+  int number = prototype ? stimulus : *network->getConfig()->STIMULUS;
+  SpikeRecord spike = {offset + index, static_cast<uint32_t>(number),
+                       static_cast<uint32_t>(time)};
+  if (ActivationHistogram *histogram = network->getHistogram()) {
+    histogram->add(spike.stimulus, spike.neuron, spike.timestamp);
+    if (!network->keepsSpikes()) {
+      return;
+    }
+  }
+  activations.push(spike);
+}
 
-    // retrieve the top message in priority q
-    Message *message = getMessage();
+/**
+ * @brief Move NeuronGroup::activations into the Log.
+ *
+ * Called once the group's thread is joined.
+ */
+void NeuronGroup::transferData() {
+  network->lg->addSpikes(activations);
+  activations.clear();
+}
 
-    message->post_synaptic_neuron->run(message);
+/**
+ * @brief retroactively decays a Neuron's membrane potential.
+ *
+ * Decays from the Neuron's last decay up to `to` in steps of 3 timestamps,
+ * either in closed form with the SNN's DecayTable or step by step depending on
+ * RuntimConfig::decay_mode. A Neuron that has never decayed only has its last
+ * decay set.
+ *
+ * @param index Neuron::getIndex of the Neuron
+ * @param to The ending timestamp to decay to
+ */
+void NeuronGroup::retroactiveDecay(uint32_t index, int to) {
+  RuntimConfig *config = network->getConfig();
+  double v_rest = config->REFRACTORY_MEMBRANE_POTENTIAL;
+
+  int from = state.last_decay[index];
+  if (from < 0) {
+    state.last_decay[index] = to;
+    return;
+  }
 
-    // Update our empty bool
-    empty = message_q.empty();
+  const DecayTable &table = network->getDecayTable();
+  if (config->decay_mode == DecayMode::Reference || !table.valid() ||
+      table.getTau() != config->TAU) {
+    state.last_decay[index] = DecayTable::reference(
+        state.membrane_potential[index], v_rest, config->TAU, from, to);
+    return;
   }
+
+  int steps = DecayTable::steps(from, to);
+  state.membrane_potential[index] =
+      table.decay(state.membrane_potential[index], v_rest, steps);
+  state.last_decay[index] = from + DecayTable::time_step * steps;
 }
 
 /**
  * @brief Main run cycle for a NeuronGroup.
  *
  * Checks the global bool ::active each cycle. Runs active neurons.
- * Before joining the main thread, transfers data from Neuron::log_data to
- * Log::log_data
+ * The activations stay in NeuronGroup::activations until
+ * NeuronGroup::transferData
  *
  */
 void *NeuronGroup::run() {
 
-  if (network->getConfig()->NUMBER_GROUPS == 1) {
-    runSingleThread();
-  } else {
+  if (network->getConfig()->NUMBER_GROUPS > 1) {
     runMultithread();
+  } else if (network->getConfig()->engine == Engine::ClockDriven) {
+    runClockDriven();
+  } else {
+    runSingleThread();
   }
   return nullptr;
 }
@@ -242,61 +457,169 @@ const vector<Neuron *> &NeuronGroup::getNeuronVec() const {
 /**
  * @brief Reset NeuronGroup.
  *
- * Resets all `Neuron`s
+ * Resets the state of all `Neuron`s, which then decay from tick 0 of the next
+ * stimulus.
  *
  */
 void NeuronGroup::reset() {
-  for (auto neuron : all_neurons) {
-    if (neuron->getType() == Input) {
-      neuron = dynamic_cast<InputNeuron *>(neuron);
+  if (!message_q.empty()) {
+    network->lg->log(WARNING, "Message queue not empty at time of reset");
+    network->lg->groupNeuronState(WARNING, "Group %d intergroup connections",
+                                  id, 0);
+    for (const Inbound &link : inbound) {
+      network->lg->state(WARNING, "\tGroup %d", link.from->getID());
     }
-    pthread_mutex_lock(&message_q_tex);
-    bool empty = message_q.empty();
-    pthread_mutex_unlock(&message_q_tex);
-
-    if (!empty) {
-      network->lg->log(WARNING, "Message queue not empty at time of reset");
-      network->lg->groupNeuronState(WARNING, "Group %d intergroup connections",
-                                    id, 0);
-      for (auto g : interGroupConnections) {
-        network->lg->state(WARNING, "\tGroup %d", g->getID());
-      }
-      network->lg->groupNeuronState(WARNING, "Group %d remaining messages", id,
-                                    0);
-
-      // nullptr check covers the case of stimulus messages
-      for (auto m : message_q) {
-        network->lg->groupNeuronState(
-            WARNING, "\tFrom: %d Time: %d",
-            m->presynaptic_neuron == nullptr
-                ? -1
-                : m->presynaptic_neuron->getGroup()->getID(),
-            m->timestamp);
-      }
+    network->lg->groupNeuronState(WARNING, "Group %d remaining messages", id,
+                                  0);
+
+    message_q.forEach([this](uint32_t index) {
+      const Message &m = message_pool.at(index);
+      network->lg->groupNeuronState(
+          WARNING, "\tFrom: %d Time: %d",
+          m.message_type == Message_t::Stimulus ||
+                  m.message_type == Message_t::Stimulus_Tick
+              ? -1
+              : m.origin_group,
+          m.timestamp);
+    });
+  }
+
+  state.reset(network->getConfig()->INITIAL_MEMBRANE_POTENTIAL);
+
+  // drop anything left over so the next stimulus starts from tick 0, every
+  // pooled Message is released at once
+  message_q.clear();
+  message_pool.recycle();
+  for (Inbound &link : inbound) {
+    link.ring->clear();
+  }
+
+  updateTimestamp(0);
+}
+
+/**
+ * @brief Pop the oldest Message from NeuronGroup::message_q.
+ *
+ * The Message is copied out and its slot in NeuronGroup::message_pool is
+ * freed.
+ *
+ * @return the Message
+ */
+Message NeuronGroup::getMessage() {
+  return message_pool.release(message_q.pop());
+}
+
+/**
+ * @brief Store a Message in the pool and queue it for its timestamp.
+ *
+ * Only this group's thread (or the main thread between runs) touches
+ * NeuronGroup::message_q, other groups go through NeuronGroup::deliver.
+ *
+ * @param message Message to copy into NeuronGroup::message_pool
+ */
+void NeuronGroup::addToMessageQ(const Message &message) {
+  message_q.push(message_pool.acquire(message), message.timestamp);
+}
+
+/**
+ * @brief Forget the InputNeuron values of the previous stimulus.
+ */
+void NeuronGroup::clearStimulus() {
+  stimulus_inputs.clear();
+  stimulus_latency = 0;
+}
+
+/**
+ * @brief Have an InputNeuron of this group receive the current stimulus.
+ *
+ * @param index Neuron::getIndex of the InputNeuron
+ * @param latency ticks before it receives anything
+ * @param value added to its membrane potential on every draw
+ */
+void NeuronGroup::addStimulusInput(uint32_t index, int latency, float value) {
+  if (stimulus_inputs.empty() || latency < stimulus_latency) {
+    stimulus_latency = latency;
+  }
+  stimulus_inputs.push_back(StimulusInput{index, latency, value});
+}
+
+/**
+ * @brief Queue one Message_t::Stimulus_Tick per drawn tick.
+ *
+ * A tick drawn several times is queued once with the number of draws. Ticks
+ * before the smallest latency of the stimulus inputs reach none of them and
+ * are left out.
+ *
+ * @param timestamps ticks drawn by SNN::generateInputNeuronEvents
+ */
+void NeuronGroup::queueStimulus(const std::vector<int> &timestamps) {
+  if (stimulus_inputs.empty()) {
+    return;
+  }
+  std::vector<int> ticks(timestamps);
+  std::sort(ticks.begin(), ticks.end());
+  for (size_t i = 0; i < ticks.size();) {
+    size_t j = i;
+    while (j < ticks.size() && ticks[j] == ticks[i]) {
+      j++;
+    }
+    if (ticks[i] >= stimulus_latency) {
+      addToMessageQ(Message(0, j - i, Message_t::Stimulus_Tick, ticks[i]));
     }
-    neuron->reset();
+    i = j;
   }
-  pthread_mutex_lock(&time_stamp_tex);
-  most_recent_timestamp = 0;
-  pthread_mutex_unlock(&time_stamp_tex);
 }
 
-Message *NeuronGroup::getMessage() {
-  // pthread_mutex_lock(&message_q_tex);
-  // std::cout << id << " locked message_q_tex\n";
-  Message *ret = *message_q.begin();
-  message_q.erase(message_q.begin());
-  // pthread_mutex_unlock(&message_q_tex);
-  // std::cout << id << " unlocked message_q_tex\n";
-  return ret;
+/**
+ * @brief Send a Message from this group's thread to `target`.
+ *
+ * Messages within the group are queued directly, others are pushed on the
+ * link's SpscRing. A replica runs on a single thread and queues every Message
+ * directly in the matching group of its replica. While the ring is full this
+ * group drains its own inbound rings, so two groups filling each other's rings
+ * cannot deadlock.
+ *
+ * @param target group owning the postsynaptic Neuron
+ * @param message Message to send
+ */
+void NeuronGroup::deliver(NeuronGroup *target, const Message &message) {
+  if (replica) {
+    (*replica)[target->getID() - 1]->addToMessageQ(message);
+    return;
+  }
+  if (target == this) {
+    addToMessageQ(message);
+    return;
+  }
+  SpscRing<Message> *ring = outbound[target->getID() - 1];
+  while (!ring->push(message)) {
+    drainInbound();
+    sched_yield();
+  }
 }
 
-void NeuronGroup::addToMessageQ(Message *message) {
-  pthread_mutex_lock(&message_q_tex);
-  // std::cout << id << " locked message_q_tex\n";
-  message_q.insert(message);
-  pthread_mutex_unlock(&message_q_tex);
-  // std::cout << id << " unlocked message_q_tex\n";
+/**
+ * @brief Move every Message waiting on an inbound ring into
+ * NeuronGroup::message_q.
+ */
+void NeuronGroup::drainInbound() {
+  for (Inbound &link : inbound) {
+    link.ring->drain([this](const Message &m) { addToMessageQ(m); });
+  }
+}
+
+/**
+ * @brief First tick an inbound group may still send a Message for.
+ *
+ * Every tick before it is complete once the inbound rings are drained. Without
+ * inbound links nothing can arrive and the bound is past the stimulus.
+ */
+int NeuronGroup::safeBound() {
+  int bound = network->getConfig()->time_per_stimulus + 1;
+  for (const Inbound &link : inbound) {
+    bound = std::min(bound, link.from->getTimestamp() + link.lookahead);
+  }
+  return bound;
 }
 
 int NeuronGroup::generateRandomSynapses(int number_edges) {
@@ -326,14 +649,12 @@ int NeuronGroup::generateRandomSynapses(int number_edges) {
 
   Matrix mat(n_neurons, std::vector<int>(n_non_input, 0));
 
-  auto gen = network->getGen();
-  std::uniform_int_distribution<> rows(0, n_neurons - 1);
-  std::uniform_int_distribution<> cols(0, n_non_input - 1);
+  RandomStream stream = network->getStream(Random_t::Synapses, id);
 
   int number_connections = 0;
   while (number_connections < number_edges) {
-    auto row = static_cast<MatrixSz>(rows(gen));
-    auto col = static_cast<MatrixSz>(cols(gen));
+    auto row = static_cast<MatrixSz>(stream.below(n_neurons));
+    auto col = static_cast<MatrixSz>(stream.below(n_non_input));
 
     if (mat[row][col] || row == col) {
       continue;
@@ -365,61 +686,73 @@ int NeuronGroup::generateRandomSynapses(int number_edges) {
   }
   return number_edges;
 }
-void NeuronGroup::addInterGroupConnections(NeuronGroup *group) {
-  interGroupConnections.push_back(group);
+
+/**
+ * @brief Drop every intergroup link.
+ *
+ * @param number_groups number of groups NeuronGroup::outbound is sized for
+ */
+void NeuronGroup::clearLinks(size_t number_groups) {
+  for (Inbound &link : inbound) {
+    delete link.ring;
+  }
+  inbound.clear();
+  outbound.assign(number_groups, nullptr);
 }
-Neuron *NeuronGroup::getNonInputNeuron() const {
-  static std::uniform_int_distribution<> index(0, nI_neurons.size() - 1);
-  return nI_neurons[index(network->getGen())];
+
+/**
+ * @brief Add a link carrying Messages from `from` to this group.
+ *
+ * The link's ring is owned by this group, `from` pushes to it through its
+ * NeuronGroup::outbound.
+ *
+ * @param from sending group
+ * @param lookahead smallest synapse delay from `from` into this group
+ */
+void NeuronGroup::addInbound(NeuronGroup *from, int lookahead) {
+  SpscRing<Message> *ring = new SpscRing<Message>();
+  inbound.push_back(Inbound{from, lookahead, ring});
+  from->outbound[id - 1] = ring;
+}
+Neuron *NeuronGroup::getNonInputNeuron(RandomStream &stream) const {
+  return nI_neurons[stream.below(nI_neurons.size())];
 }
-Neuron *NeuronGroup::getRandNeuron() const {
-  static std::uniform_int_distribution<> index(0, all_neurons.size() - 1);
-  return all_neurons[index(network->getGen())];
+Neuron *NeuronGroup::getRandNeuron(RandomStream &stream) const {
+  return all_neurons[stream.below(all_neurons.size())];
 }
 
+/**
+ * @brief Publish NeuronGroup::most_recent_timestamp.
+ *
+ * The release store makes every Message pushed to an outbound ring before it
+ * visible to a group that reads the new timestamp.
+ */
 void NeuronGroup::updateTimestamp(int mr) {
-  pthread_mutex_lock(&time_stamp_tex);
-  most_recent_timestamp = mr;
-  pthread_mutex_unlock(&time_stamp_tex);
+  most_recent_timestamp.store(mr, std::memory_order_release);
 }
 int NeuronGroup::getTimestamp() {
-  pthread_mutex_lock(&time_stamp_tex);
-  int mr = most_recent_timestamp;
-  pthread_mutex_unlock(&time_stamp_tex);
-
-  return mr;
-}
-IGlimit NeuronGroup::findLimitingGroup() {
-  int min = getTimestamp();
-  NeuronGroup *limiter = nullptr;
-  IGlimit ret(limiter, min);
-  for (auto g : interGroupConnections) {
-    int t = g->getTimestamp();
-    if (t < ret.timestamp) {
-      ret.timestamp = t;
-      ret.limitingGroup = g;
-    }
-  }
-  return ret;
+  return most_recent_timestamp.load(std::memory_order_acquire);
 }
 
-void NeuronGroup::logUnseqMessage(Message *message, int last_timestamp) {
-  switch (message->message_type) {
+void NeuronGroup::logUnseqMessage(const Message &message,
+                                  int last_timestamp) {
+  switch (message.message_type) {
   case Message_t::From_Neighbor: {
     network->lg->message(ERROR,
                          "\n\tGroup %d\n\tLast timestamp: %d \n\tMessage_t: "
                          "%s \n\tFrom Group: %d \n\tTimestamp: %d",
-                         id, last_timestamp, message->message_type,
-                         message->presynaptic_neuron->getGroup()->getID(),
-                         message->timestamp);
+                         id, last_timestamp, message.message_type,
+                         message.origin_group,
+                         message.timestamp);
     break;
   }
-  case Message_t::Stimulus: {
+  case Message_t::Stimulus:
+  case Message_t::Stimulus_Tick: {
     network->lg->message(ERROR,
                          "\n\tGroup %d\n\tLast timestamp: %d \n\tMessage_t: "
                          "%s \n\tTimestamp: %d",
-                         id, last_timestamp, message->message_type,
-                         message->timestamp);
+                         id, last_timestamp, message.message_type,
+                         message.timestamp);
     break;
   }
   case Message_t::Refractory:
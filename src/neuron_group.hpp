@@ -1,16 +1,22 @@
 #ifndef NEURON_GROUP
 #define NEURON_GROUP
 
+#include "calendar_queue.hpp"
 #include "log.hpp"
 #include "message.hpp"
+#include "neuron_state.hpp"
+#include "pool.hpp"
+#include "random_stream.hpp"
+#include "spike_buffer.hpp"
+#include "spsc_ring.hpp"
+#include "tick_engine.hpp"
+#include <atomic>
 #include <list>
 #include <pthread.h>
-#include <set>
 
 class Neuron;
 class InputNeuron;
 class SNN;
-struct IGlimit;
 
 using std::list;
 
@@ -19,53 +25,115 @@ private:
   vector<Neuron *> all_neurons;
   vector<Neuron *> nI_neurons;
   vector<InputNeuron *> input_neurons;
+  NeuronState state; /**< indexed by Neuron::getIndex */
+  uint32_t offset = 0; /**< SynapseGraph node of the first Neuron */
   int id;
 
-  int most_recent_timestamp;
-  pthread_mutex_t time_stamp_tex = PTHREAD_MUTEX_INITIALIZER;
-  pthread_mutex_t limit_tex = PTHREAD_MUTEX_INITIALIZER;
-  pthread_cond_t limit_cond = PTHREAD_COND_INITIALIZER;
+  /**
+   * Published by this group's thread: no tick before it will be processed
+   * anymore, so every Message it still sends is at least this plus the
+   * lookahead of the link
+   */
+  std::atomic<int> most_recent_timestamp;
+
+  /**
+   * @brief Incoming intergroup link, see NeuronGroup::addInbound.
+   */
+  struct Inbound {
+    NeuronGroup *from;
+    int lookahead; /**< smallest synapse delay on the link */
+    SpscRing<Message> *ring;
+  };
 
   pthread_t thread;
   SNN *network;
-  std::multiset<Message *, MessageComp> message_q;
-  pthread_mutex_t message_q_tex = PTHREAD_MUTEX_INITIALIZER;
-  std::vector<NeuronGroup *> interGroupConnections;
+  FreeListPool<Message> message_pool;
+  CalendarQueue<uint32_t> message_q; /**< indices into message_pool */
+  size_t processed_messages = 0;
+  TickEngine engine;
+  std::vector<Message> batch; /**< messages of the tick TickEngine runs */
+
+  /**
+   * @brief InputNeuron receiving the current stimulus, see
+   * NeuronGroup::addStimulusInput.
+   */
+  struct StimulusInput {
+    uint32_t index; /**< Neuron::getIndex */
+    int latency;    /**< ticks before it receives anything */
+    float value;
+  };
+  std::vector<StimulusInput> stimulus_inputs; /**< in SNN::input_neurons order */
+  int stimulus_latency = 0; /**< smallest latency of NeuronGroup::stimulus_inputs */
+  std::vector<Inbound> inbound;
+  std::vector<SpscRing<Message> *> outbound; /**< indexed by group ID - 1 */
+
+  // replicas, see StimulusPool
+  NeuronGroup *prototype = nullptr; /**< group this one replicates */
+  const std::vector<NeuronGroup *> *replica = nullptr; /**< by group ID - 1 */
+  SpikeBuffer activations; /**< since the last NeuronGroup::transferData */
+  int stimulus = 0; /**< stimulus number a replica logs with */
 
 public:
   NeuronGroup(int _id, int number_neurons, int number_input_neurons,
               SNN *network);
+  NeuronGroup(NeuronGroup *prototype,
+              const std::vector<NeuronGroup *> *replica);
   ~NeuronGroup();
 
   void *run();
 
   void runSingleThread();
   void runMultithread();
+  void runClockDriven();
+  void runTick(int timestamp);
+  void runNeuron(const Message &message);
+  void runStimulusTick(const Message &tick);
+  void fire(uint32_t index);
+  void propagate(uint32_t index, double potential);
+  void addActivation(uint32_t index, int time);
+  void transferData();
+  void retroactiveDecay(uint32_t index, int to);
   void startThread() {
     pthread_create(&thread, NULL, NeuronGroup::thread_helper, this);
   }
 
   int getID() const { return id; }
+  NeuronGroup *getPrototype() const { return prototype; }
+  void setStimulus(int number) { stimulus = number; }
+  SpikeBuffer &getActivations() { return activations; }
+  bool hasMessages() const { return !message_q.empty(); }
+  int nextTimestamp() { return message_q.frontTime(); }
+  NeuronState &getState() { return state; }
+  uint32_t getOffset() const { return offset; }
+  void setOffset(uint32_t o) { offset = o; }
+  const NeuronState &getState() const { return state; }
 
   pthread_t getThreadID() const { return thread; }
   SNN *getNetwork() const { return network; }
   int neuronCount() const;
-  Message *getMessage();
-  void addToMessageQ(Message *message);
+  size_t getProcessedCount() const { return processed_messages; }
+  size_t getMessageAllocations() const {
+    return message_pool.getAllocationCount();
+  }
+  Message getMessage();
+  void addToMessageQ(const Message &message);
+  void clearStimulus();
+  void addStimulusInput(uint32_t index, int latency, float value);
+  void queueStimulus(const std::vector<int> &timestamps);
+  void deliver(NeuronGroup *target, const Message &message);
   int generateRandomSynapses(int n_edges);
-  void addInterGroupConnections(NeuronGroup *group);
-  pthread_mutex_t &getMessageQtex() { return message_q_tex; }
+  void clearLinks(size_t number_groups);
+  void addInbound(NeuronGroup *from, int lookahead);
+  void drainInbound();
+  int safeBound();
   void reset();
   vector<Neuron *> &getMutNeuronVec();
-  Neuron *getNonInputNeuron() const;
-  Neuron *getRandNeuron() const;
+  Neuron *getNonInputNeuron(RandomStream &stream) const;
+  Neuron *getRandNeuron(RandomStream &stream) const;
   const vector<Neuron *> &getNeuronVec() const;
   void updateTimestamp(int mr);
   int getTimestamp();
-  IGlimit findLimitingGroup();
-  pthread_cond_t &getLimitCond() { return limit_cond; }
-  pthread_mutex_t &getLimitTex() { return limit_tex; }
-  void logUnseqMessage(Message *message, int last_timestamp);
+  void logUnseqMessage(const Message &message, int last_timestamp);
 
   /*--------------------------------------------------------------*\
    *                  Thread helper:
@@ -76,13 +144,5 @@ public:
     return ((NeuronGroup *)instance)->run();
   }
 };
-struct IGlimit {
-  NeuronGroup *limitingGroup;
-  int timestamp;
-  IGlimit(NeuronGroup *_g, int _t) : limitingGroup(_g), timestamp(_t){};
-  pthread_cond_t &getLimitCond() { return limitingGroup->getLimitCond(); }
-  pthread_mutex_t &getLimitTex() { return limitingGroup->getLimitTex(); }
-  void updateTimestamp() { timestamp = limitingGroup->getTimestamp(); }
-};
 
 #endif // !NEURON_GROUP
@@ -0,0 +1,59 @@
+/** @file */
+#ifndef NEURON_STATE
+#define NEURON_STATE
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Structure of arrays holding the dynamic state of a NeuronGroup.
+ *
+ * Every array is indexed by the local index of a Neuron in its NeuronGroup
+ * (Neuron::getIndex). Keeping each field contiguous lets NeuronGroup run the
+ * refractory check, decay and threshold check on an event without touching the
+ * Neuron objects, and turns NeuronGroup::reset into a handful of fills.
+ */
+struct NeuronState {
+  std::vector<double> membrane_potential;
+  std::vector<int> last_decay; /**< Timestamp of the most recent decay */
+  std::vector<int> refractory_start; /**< Start of the last refractory period */
+  std::vector<int> last_fire;
+  std::vector<double> activation_threshold;
+  std::vector<int> refractory_duration;
+  std::vector<double> refractory_potential;
+
+  size_t size() const { return membrane_potential.size(); }
+
+  /**
+   * @brief Size every array for `n` neurons in their initial state.
+   *
+   * Matches the state of a freshly constructed Neuron: no decay has happened
+   * yet (last_decay of -1) and the refractory period starts at 0.
+   */
+  void assign(size_t n, double initial_potential, double threshold,
+              int refractory, double refractory_membrane_potential) {
+    membrane_potential.assign(n, initial_potential);
+    last_decay.assign(n, -1);
+    refractory_start.assign(n, 0);
+    last_fire.assign(n, 0);
+    activation_threshold.assign(n, threshold);
+    refractory_duration.assign(n, refractory);
+    refractory_potential.assign(n, refractory_membrane_potential);
+  }
+
+  /**
+   * @brief Return every neuron to its between-stimulus state.
+   *
+   * Parameters (threshold, refractory duration and potential) are kept.
+   */
+  void reset(double initial_potential) {
+    std::fill(membrane_potential.begin(), membrane_potential.end(),
+              initial_potential);
+    std::fill(last_decay.begin(), last_decay.end(), 0);
+    std::fill(refractory_start.begin(), refractory_start.end(), -INT_MAX);
+  }
+};
+
+#endif // !NEURON_STATE
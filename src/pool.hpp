@@ -0,0 +1,71 @@
+/** @file */
+#ifndef POOL
+#define POOL
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Free-list pool of values addressed by a 32 bit index.
+ *
+ * Values are stored contiguously and handed out as indices, so containers that
+ * reference them (NeuronGroup::message_q) only hold 4 bytes per element.
+ * Released slots are reused before the storage grows.
+ *
+ * FreeListPool::allocations counts how many times the backing storage had to
+ * grow, i.e. the number of heap allocations done on behalf of the pool. Once a
+ * pool has warmed up this stays constant across stimuli.
+ */
+template <typename T> class FreeListPool {
+private:
+  std::vector<T> slots;
+  std::vector<uint32_t> free_slots;
+  size_t allocations = 0;
+  size_t acquired = 0;
+
+public:
+  /**
+   * @brief Store a value and return its index.
+   */
+  uint32_t acquire(const T &value) {
+    acquired++;
+    if (!free_slots.empty()) {
+      uint32_t index = free_slots.back();
+      free_slots.pop_back();
+      slots[index] = value;
+      return index;
+    }
+    if (slots.size() == slots.capacity()) {
+      allocations++;
+    }
+    slots.push_back(value);
+    return static_cast<uint32_t>(slots.size() - 1);
+  }
+
+  /**
+   * @brief Copy a value out of the pool and free its slot.
+   */
+  T release(uint32_t index) {
+    if (free_slots.size() == free_slots.capacity()) {
+      allocations++;
+    }
+    free_slots.push_back(index);
+    return slots[index];
+  }
+
+  const T &at(uint32_t index) const { return slots[index]; }
+
+  /**
+   * @brief Free every slot at once, keeping the storage.
+   */
+  void recycle() {
+    slots.clear();
+    free_slots.clear();
+  }
+
+  size_t getAllocationCount() const { return allocations; }
+  size_t getAcquiredCount() const { return acquired; }
+};
+
+#endif // !POOL
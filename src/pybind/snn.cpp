@@ -1,5 +1,7 @@
 #include "snn.hpp"
 #include "../../extern/pybind/include/pybind11/stl.h"
+#include "../activation_histogram.hpp"
+#include "../result_region.hpp"
 #include "../runtime.hpp"
 #include <algorithm>
 #include <chrono>
@@ -10,12 +12,64 @@
 #include <pthread.h>
 #include <sstream>
 #include <stdexcept>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <unordered_map>
 #include <vector>
 
 int add(int i, int j) { return i + j; }
 
+/**
+ * @brief Run the work on a new thread, or right here if none can be started.
+ */
+void BatchRun::start() {
+  if (pthread_create(&thread, NULL, BatchRun::thread_helper, this) != 0) {
+    thread_helper(this);
+    joined = true;
+  }
+}
+
+void *BatchRun::thread_helper(void *instance) {
+  BatchRun *run = static_cast<BatchRun *>(instance);
+  try {
+    run->work();
+  } catch (const std::exception &e) {
+    run->error = e.what()[0] ? e.what() : "batch failed";
+  }
+  run->finished.store(true, std::memory_order_release);
+  return nullptr;
+}
+
+/**
+ * @brief Wait for the work to finish, from any number of threads.
+ */
+void BatchRun::wait() {
+  pthread_mutex_lock(&join_tex);
+  if (!joined) {
+    pthread_join(thread, NULL);
+    joined = true;
+  }
+  pthread_mutex_unlock(&join_tex);
+}
+
+/**
+ * @brief Throw what the run threw, if anything. Only after BatchRun::wait.
+ *
+ * @param unraised_only skip an error that was already thrown once
+ */
+void BatchRun::rethrow(bool unraised_only) {
+  if (error.empty() || (unraised_only && raised)) {
+    return;
+  }
+  raised = true;
+  throw std::runtime_error(error);
+}
+
+BatchRun::~BatchRun() {
+  wait();
+  pthread_mutex_destroy(&join_tex);
+}
+
 pySNN::pySNN(ConfigDict dict) : SNN(), configDict(dict) {
   lg->setNetwork(this); // log gets allocated in SNN()
   config = new RuntimConfig(this);
@@ -28,12 +82,35 @@ pySNN::pySNN(ConfigDict dict) : SNN(), configDict(dict) {
   barrier = new Barrier(config->NUMBER_GROUPS + 1);
   // no need for input file reader
 
-  gen = std::mt19937(rd());
-  gen.seed(config->RAND_SEED);
   image = nullptr; // we have to wait to initalize the images until we know
   // size of the python buffer
 }
 
+pySNN::~pySNN() {
+  if (pending) {
+    pending->wait();
+  }
+}
+
+/**
+ * @brief Wait for a batch started by pySNN::runBatchAsync, if any.
+ *
+ * Everything reading results or changing the network calls this first.
+ * Called with the GIL held, which is released while waiting. Raises the error
+ * of a failed batch, unless BatchRun.result already did.
+ */
+void pySNN::finishAsync() {
+  if (!pending) {
+    return;
+  }
+  {
+    py::gil_scoped_release release;
+    pending->wait();
+  }
+  std::shared_ptr<BatchRun> run = std::move(pending);
+  run->rethrow(true);
+}
+
 ConfigDict pySNN::getDefaultConfig() {
 
   ConfigDict dict = {{"neuron_count", 0},
@@ -45,6 +122,7 @@ ConfigDict pySNN::getDefaultConfig() {
                      {"activation_threshold", -5.0},
                      {"refractory_membrane_potential", -7.0},
                      {"tau", 100.0},
+                     {"decay_mode", DecayMode::ClosedForm},
                      {"max_latency", 10},
                      {"max_synapse_delay", 2},
                      {"min_synapse_delay", 1},
@@ -53,6 +131,9 @@ ConfigDict pySNN::getDefaultConfig() {
                      {"debug_level", LogLevel::NONE},
                      {"limit_log_size", true},
                      {"show_stimulus", false},
+                     {"engine", Engine::EventDriven},
+                     {"workers", 1},
+                     {"processes", 0},
                      {"time_per_stimulus", 200},
                      {"seed", -1}};
   return dict;
@@ -72,8 +153,6 @@ pySNN::pySNN(std::string configFile) : SNN() {
   barrier = new Barrier(config->NUMBER_GROUPS + 1);
   // no need for input file reader
 
-  gen = std::mt19937(rd());
-  gen.seed(config->RAND_SEED);
   image = nullptr; // we have to wait to initalize the images until we know
   // the
   //  size of the python buffer
@@ -89,8 +168,6 @@ pySNN::pySNN(std::vector<std::string> args) : SNN() {
   barrier = new Barrier(config->NUMBER_GROUPS + 1);
   // no need for input file reader
 
-  gen = std::mt19937(rd());
-  gen.seed(config->RAND_SEED);
   image = nullptr; // we have to wait to initalize the images until we know the
                    // size of the python buffer
 }
@@ -121,23 +198,41 @@ int getIndex(const std::tuple<int, int> &pair, int maxLayer) {
   return index;
 }
 
+/**
+ * @brief Add random synapses, see SNN::generateRandomSynapsesAdjMatrixGS.
+ */
+void pySNN::generateSynapses() {
+  finishAsync();
+  generateRandomSynapsesAdjMatrixGS();
+}
+
 /**
  * @brief update the Edge weights based on a dict of dicts.
  *
+ * Only for networks built from an AdjDict, whose keys it shares. Networks
+ * built from arrays have no layout to look the keys up in, see
+ * pySNN::setWeights and pySNN::setDelays instead.
+ *
  * @param dict a AdjDict representing the graph
  *
  */
 void pySNN::updateEdgeWeights(AdjDict dict) {
+  finishAsync();
+  if (!has_layout) {
+    lg->log(ERROR, "pySNN::updateEdgeWeights: network was not built from a "
+                   "dict of dicts, use setWeights and setDelays");
+    throw std::runtime_error("");
+  }
 
   using std::get;
 
+  // edges are looked up in the frozen graph
+  prepareRun();
+
   for (const auto &adjacencyPair : dict) {
 
     int originIndex = getIndex(adjacencyPair.first, maxLayer);
-
-    const auto &synapseRef =
-        nonInputNeurons.at(originIndex)
-            ->getPostSynaptic(); // get outgoing connections
+    uint32_t origin = nonInputNeurons.at(originIndex)->getGlobalIndex();
 
     for (const auto &edgeWeightPair : adjacencyPair.second) {
 
@@ -151,18 +246,13 @@ void pySNN::updateEdgeWeights(AdjDict dict) {
         delay = edgeWeightPair.second.at("delay");
       }
 
-      Neuron *destination = nonInputNeurons.at(destinationIndex);
-      bool updated = false;
-      for (auto &synapse : synapseRef) {
-        if (synapse->getPostSynaptic() == destination) {
-          synapse->updateWeight(weight);
-          synapse->updateDelay(delay);
-          updated = true;
-          break;
-        }
-      }
-
-      if (!updated) {
+      uint32_t destination =
+          nonInputNeurons.at(destinationIndex)->getGlobalIndex();
+      long edge = graph.findEdge(origin, destination);
+      if (edge != -1) {
+        graph.setWeight(edge, weight);
+        graph.setDelay(edge, delay);
+      } else {
         lg->log(LogLevel::ERROR,
                 "pySNN::updateEdgeWeights: While updating weight, destination "
                 "neuron not found in origin neurons edge list");
@@ -171,6 +261,89 @@ void pySNN::updateEdgeWeights(AdjDict dict) {
   }
 }
 
+/**
+ * @brief Origin and destination of every edge, by edge index.
+ *
+ * Edge indices are the positions in pySNN.getWeights and pySNN.getDelays and
+ * stay the same until edges are added. Neurons are numbered like the second
+ * axis of pySNN.getIndividualActivations, input neurons included.
+ *
+ * @return `(src, dst)` arrays
+ */
+py::tuple pySNN::getEdges() {
+  finishAsync();
+  graph.freeze();
+  py::ssize_t size = graph.frozenEdgeCount();
+  py::array_t<uint32_t> src(size), dst(size);
+  uint32_t *from = src.mutable_data(), *to = dst.mutable_data();
+  for (uint32_t node = 0; node < graph.nodeCount(); node++) {
+    for (uint32_t e = graph.edgesBegin(node); e < graph.edgesEnd(node); e++) {
+      from[e] = node;
+      to[e] = graph.getTarget(e);
+    }
+  }
+  return py::make_tuple(src, dst);
+}
+
+/**
+ * @brief Copy of every edge weight, by edge index (see pySNN::getEdges).
+ */
+py::array_t<double> pySNN::getWeights() {
+  finishAsync();
+  graph.freeze();
+  py::array_t<double> ret(graph.frozenEdgeCount());
+  std::copy(graph.weightData(), graph.weightData() + graph.frozenEdgeCount(),
+            ret.mutable_data());
+  return ret;
+}
+
+/**
+ * @brief Copy of every edge delay, by edge index (see pySNN::getEdges).
+ */
+py::array_t<int> pySNN::getDelays() {
+  finishAsync();
+  graph.freeze();
+  py::array_t<int> ret(graph.frozenEdgeCount());
+  std::copy(graph.delayData(), graph.delayData() + graph.frozenEdgeCount(),
+            ret.mutable_data());
+  return ret;
+}
+
+/**
+ * @brief Overwrite every edge weight in one go.
+ *
+ * Replaces pySNN::updateEdgeWeights, which looks every edge up, when all
+ * weights change at once, e.g. once per training epoch.
+ *
+ * @param weights one per edge, in the order of pySNN::getEdges
+ */
+void pySNN::setWeights(WeightArray weights) {
+  finishAsync();
+  graph.freeze();
+  if (static_cast<size_t>(weights.size()) != graph.frozenEdgeCount()) {
+    lg->value(ERROR, "pySNN::setWeights: expected one weight per edge, %d",
+              static_cast<int>(graph.frozenEdgeCount()));
+    throw std::runtime_error("");
+  }
+  graph.setWeights(weights.data());
+}
+
+/**
+ * @brief Overwrite every edge delay in one go, see pySNN::setWeights.
+ *
+ * @param delays one per edge, in the order of pySNN::getEdges
+ */
+void pySNN::setDelays(DelayArray delays) {
+  finishAsync();
+  graph.freeze();
+  if (static_cast<size_t>(delays.size()) != graph.frozenEdgeCount()) {
+    lg->value(ERROR, "pySNN::setDelays: expected one delay per edge, %d",
+              static_cast<int>(graph.frozenEdgeCount()));
+    throw std::runtime_error("");
+  }
+  graph.setDelays(delays.data());
+}
+
 /**
  * @brief Set RuntimConfig::STIMULUS_VEC and RuntimConfig::Stimulus to align
  * with pySNN::data.
@@ -180,7 +353,7 @@ void pySNN::updateEdgeWeights(AdjDict dict) {
  */
 void pySNN::updateStimulusVectorToBuffDim() {
   config->STIMULUS_VEC.clear();
-  std::vector<int>::size_type number_lines = data.size();
+  std::vector<int>::size_type number_lines = data.rows();
   for (std::vector<int>::size_type i = 0; i < number_lines; i++) {
     config->STIMULUS_VEC.push_back(i);
   }
@@ -205,12 +378,12 @@ void pySNN::generateImage() {
         "RuntimConfig::NUMBER_INPUT_NEURONS is correct (this value is set by "
         "either configuration file, or overridden by pySNN::initialize)");
   } else if (static_cast<size_t>(config->NUMBER_INPUT_NEURONS) !=
-             data.front().size()) {
+             data.columns()) {
     lg->value(WARNING,
               "Number of input neurons does not equal the number of "
               "elements per stimulus, setting number of input neurons to %d",
-              (int)data.front().size());
-    config->NUMBER_INPUT_NEURONS = data.front().size();
+              (int)data.columns());
+    config->NUMBER_INPUT_NEURONS = data.columns();
   }
 
   lg->value(LogLevel::INFO, "NUMBER_INPUT_NEURONS is %d",
@@ -237,35 +410,23 @@ void pySNN::generateImage() {
   }
 }
 
-void pySNN::updateConfigToAdjList(const AdjDict &dict) {
-  /*
-   * The passed dictionary determines the number of neurons
-   * (as opposed to the configuration file).
-   *
-   * Here we update those values and associated values
-   */
-  int numberNonInput = dict.size();
-
-  lg->value(LogLevel::INFO, "numberNonInput is %d", numberNonInput);
-
-  config->NUMBER_NEURONS = config->NUMBER_INPUT_NEURONS + numberNonInput;
-
-  lg->value(LogLevel::DEBUG, "NUMBER_NEURONS is %d", config->NUMBER_NEURONS);
-}
-
-void pySNN::initialize(AdjDict &dict) {
+/**
+ * @brief Create the NeuronGroups and Neurons, without any edges.
+ *
+ * The number of non-input Neurons comes from the passed graph rather than the
+ * configuration.
+ *
+ * @param numberNonInput nodes of the passed graph
+ */
+void pySNN::generateNeurons(size_t numberNonInput) {
   /*
    * Generate and images based on the buffer dimensions
    */
   generateImage();
 
-  /*
-   * The graph generation is completely decided based on the passed
-   * NetworkX dict of dicts.
-   *
-   * Update the Neuron counts based on that dictionary
-   */
-  updateConfigToAdjList(dict);
+  lg->value(LogLevel::INFO, "numberNonInput is %d", (int)numberNonInput);
+  config->NUMBER_NEURONS = config->NUMBER_INPUT_NEURONS + numberNonInput;
+  lg->value(LogLevel::DEBUG, "NUMBER_NEURONS is %d", config->NUMBER_NEURONS);
 
   // Neurons per group
   int neuronPerGroup = config->NUMBER_NEURONS / config->NUMBER_GROUPS;
@@ -311,9 +472,43 @@ void pySNN::initialize(AdjDict &dict) {
 
   // lg->value(LogLevel::INFO, "non-input neuron vector has size %d",
   //           (int)nonInputNeurons.size());
+}
+
+/**
+ * @brief Connect every InputNeuron to the non-input Neuron of the same index.
+ *
+ * @return number of edges added
+ */
+size_t pySNN::connectInputNeurons() {
+  size_t max_size = std::min(input_neurons.size(), nonInputNeurons.size());
+  if (max_size == 0) {
+    lg->log(LogLevel::ERROR,
+            "pySNN::connectInputNeurons: computed min size of inputNeuron "
+            "vector and nonInputNeurons vector is 0?");
+    return 0;
+  }
+
+  for (size_t i = 0; i < max_size; i++) {
+    InputNeuron *origin = input_neurons.at(i);
+    Neuron *destination = nonInputNeurons.at(i);
+    origin->addNeighbor(destination, 1, 0);
+  }
+  return max_size;
+}
+
+void pySNN::initialize(AdjDict &dict) {
+  finishAsync();
+  /*
+   * The graph generation is completely decided based on the passed
+   * NetworkX dict of dicts.
+   *
+   * Update the Neuron counts based on that dictionary
+   */
+  generateNeurons(dict.size());
 
   using std::get;
   maxLayer = std::get<0>((*dict.end()).first); // set the max layer
+  has_layout = true;
   int numEdges = 0;
 
   for (auto adjacencyPair : dict) {
@@ -338,177 +533,295 @@ void pySNN::initialize(AdjDict &dict) {
   }
 
   // add inputNeuron Connections
-  size_t max_size = std::min(input_neurons.size(), nonInputNeurons.size());
-  if (max_size == 0) {
-    lg->log(LogLevel::ERROR,
-            "pySNN::updateEdgeWeights: computed min size of inputNeuron vector "
-            "and nonInputNeurons vector is 0?");
-    return;
+  numEdges += connectInputNeurons();
+
+  config->NUMBER_EDGES = numEdges;
+}
+
+/**
+ * @brief Build the network from an edge list held in numpy arrays.
+ *
+ * Does what pySNN::initialize does with a dict of dicts, without going
+ * through a Python dict per node and per edge: edge `i` runs from non-input
+ * Neuron `src[i]` to `dst[i]`, nodes numbered from 0. Arrays that are not
+ * contiguous or of another integer/float type are converted once by numpy.
+ * A scipy CSR matrix `m` becomes an edge list with
+ * `src = np.repeat(np.arange(m.shape[0]), np.diff(m.indptr))` and
+ * `dst = m.indices`.
+ *
+ * @param src origin of every edge
+ * @param dst destination of every edge
+ * @param weight weight of every edge, empty for random weights
+ * @param delay delay of every edge, empty for random delays
+ * @param nInputNeurons input neurons, overridden by a buffer passed before
+ * @param numberNonInput non-input neurons, 0 for the largest index plus one
+ */
+void pySNN::initializeFromArrays(IndexArray src, IndexArray dst,
+                                 WeightArray weight, DelayArray delay,
+                                 size_t nInputNeurons, size_t numberNonInput) {
+  finishAsync();
+  size_t number_edges = src.size();
+  if (static_cast<size_t>(dst.size()) != number_edges ||
+      (weight.size() && static_cast<size_t>(weight.size()) != number_edges) ||
+      (delay.size() && static_cast<size_t>(delay.size()) != number_edges)) {
+    lg->log(ERROR, "pySNN::initializeFromArrays: src, dst, weight and delay "
+                   "differ in length");
+    throw std::runtime_error("");
+  }
+  const uint32_t *from = src.data();
+  const uint32_t *to = dst.data();
+  const double *weights = weight.size() ? weight.data() : nullptr;
+  const int *delays = delay.size() ? delay.data() : nullptr;
+
+  uint32_t largest = 0;
+  for (size_t i = 0; i < number_edges; i++) {
+    largest = std::max(largest, std::max(from[i], to[i]));
+  }
+  if (numberNonInput == 0 && number_edges) {
+    numberNonInput = static_cast<size_t>(largest) + 1;
+  } else if (number_edges && largest >= numberNonInput) {
+    lg->value(ERROR,
+              "pySNN::initializeFromArrays: edge to neuron %d, past the "
+              "number of neurons",
+              static_cast<int>(largest));
+    throw std::runtime_error("");
   }
 
-  for (size_t i = 0; i < max_size; i++) {
-    InputNeuron *origin = input_neurons.at(i);
-    Neuron *destination = nonInputNeurons.at(i);
-    origin->addNeighbor(destination, 1, 0);
-    numEdges++;
+  config->NUMBER_INPUT_NEURONS = nInputNeurons;
+  generateNeurons(numberNonInput);
+  has_layout = false;
+
+  graph.reserve(number_edges + input_neurons.size());
+  for (size_t i = 0; i < number_edges; i++) {
+    uint32_t origin = nonInputNeurons[from[i]]->getGlobalIndex();
+    uint32_t target = nonInputNeurons[to[i]]->getGlobalIndex();
+    double edge_weight =
+        weights ? weights[i] : randomSynapseWeight(origin, target);
+    int edge_delay = delays ? delays[i] : randomSynapseDelay(origin, target);
+    graph.addEdge(origin, target, edge_weight, edge_delay);
   }
 
-  config->NUMBER_EDGES = numEdges;
+  config->NUMBER_EDGES = number_edges + connectInputNeurons();
 }
 
 void pySNN::initialize(AdjDict dict, size_t nInputNeurons) {
+  finishAsync();
   config->NUMBER_INPUT_NEURONS = nInputNeurons;
   initialize(dict);
 }
 
-void pySNN::initialize(AdjDict dict, py::buffer buff) {
-  processPyBuff(buff);
+void pySNN::initialize(AdjDict dict, py::buffer buff, double scale) {
+  finishAsync();
+  processPyBuff(buff, scale);
   initialize(dict);
 }
 
 /**
- * @brief initialize pySNN::data with data from buffer
+ * @brief Point pySNN::data at the rows of a buffer, without copying them.
  *
- * Given a numpy array of type py::buffer, generate a matrix
- * (std::vector<std::vector<double>>) that is a copy of that
- * matrix and store it in pySNN::data
+ * Given a 2D numpy array of float64, float32 or uint8, pySNN::data reads its
+ * elements in place through the array's strides, converted to double and
+ * multiplied by `scale` (e.g. `1 / 255` for raw MNIST pixels). The buffer is
+ * held until the next call or pySNN::batchReset, numpy refuses to resize the
+ * array meanwhile.
  *
  * @param buff reference to py::buffer (numpy array)
+ * @param scale every element is multiplied by it
  */
-void pySNN::processPyBuff(py::buffer &buff) {
-  if (!data.empty()) {
-    data.clear();
-  }
+void pySNN::processPyBuff(py::buffer &buff, double scale) {
+  data = InputMatrix();
+  data_view = py::buffer_info();
   // get buffer
   py::buffer_info info = buff.request();
 
-  if (info.format != py::format_descriptor<double>::format()) {
+  InputMatrix::Type type;
+  if (info.format == py::format_descriptor<double>::format()) {
+    type = InputMatrix::Type::FLOAT64;
+  } else if (info.format == py::format_descriptor<float>::format()) {
+    type = InputMatrix::Type::FLOAT32;
+  } else if (info.format == py::format_descriptor<uint8_t>::format()) {
+    type = InputMatrix::Type::UINT8;
+  } else {
     lg->string(ERROR,
-               "Invalid datatype in numpy array: expected double, got python "
-               "format: %s",
+               "Invalid datatype in numpy array: expected float64, float32 or "
+               "uint8, got python format: %s",
                info.format.c_str());
     throw std::runtime_error("");
   }
-
-  for (auto i = 0; i < info.shape.at(0); i++) {
-    const double *row_ptr =
-        (double *)info.ptr + i * info.strides.at(0) / sizeof(double);
-    std::vector<double> row;
-    for (auto j = 0; j < info.shape.at(1); j++) {
-      row.push_back(*(row_ptr + j * info.strides.at(1) / sizeof(double)));
-    }
-    data.push_back(row);
-  }
-}
-void pySNN::runChildProcess(int fd) {
-  // auto start = std::chrono::high_resolution_clock::now();
-  // set input neuron options
-  for (std::vector<InputNeuron *>::size_type i = 0; i < input_neurons.size();
-       i++) {
-    input_neurons.at(i)->setInputValue(dataToRun.at(i));
+  if (info.ndim != 2) {
+    lg->value(ERROR,
+              "Invalid numpy array: expected 2 dimensions, got %d",
+              (int)info.ndim);
+    throw std::runtime_error("");
   }
 
-  generateInputNeuronEvents();
+  data = InputMatrix(info.ptr, info.shape.at(0), info.shape.at(1),
+                     info.strides.at(0), info.strides.at(1), type, scale);
+  data_view = std::move(info);
+}
+/**
+ * @brief Worker loop of a forked child, see pySNN::forkRun.
+ *
+ * Takes stimulus indices off `next` until every row of pySNN::data is handed
+ * out. Every stimulus starts from a reset network and draws its input
+ * timestamps from its own RandomStream, so its activations are the same no
+ * matter which child runs it or what ran before.
+ *
+ * @param region where the activations go, see Log::writeToRegion
+ * @param next index of the next stimulus, shared by every child
+ */
+void pySNN::runChildProcess(ResultRegion &region, std::atomic<size_t> &next) {
+  for (size_t i = next.fetch_add(1); i < data.rows(); i = next.fetch_add(1)) {
+    config->STIMULUS = config->STIMULUS_VEC.begin() + i;
+    pySetNextStim();
+    reset();
+    generateInputNeuronEvents();
 
-  for (auto group : groups) {
-    group->run();
-  }
-  // auto end = std::chrono::high_resolution_clock::now();
-  // std::chrono::duration<double> elapsed = end - start;
-  // std::ostringstream oSS;
-
-  // if (elapsed.count() > 0.09) {
-  //   for (const auto &d : dataToRun) {
-  //     oSS << d << " ";
-  //   }
-  //   oSS << "\n";
-  // }
-
-  // pid,evaluationtime
-  // oSS << getpid() << "," << elapsed.count();
-
-  int sum = 0;
-  for (const auto &g : groups) {
-    for (const auto &n : g->getNeuronVec()) {
-      sum += std::count_if(
-          n->getLogData().begin(), n->getLogData().end(),
-          [](LogData *d) { return d->message_type == Message_t::Refractory; });
+    for (auto group : groups) {
+      group->startThread();
+    }
+    for (auto group : groups) {
+      pthread_join(group->getThreadID(), NULL);
     }
   }
-  // ,activations
-  // oSS << "," << sum;
-  // start = std::chrono::high_resolution_clock::now();
-  lg->writeToFD(fd, groups);
-  // end = std::chrono::high_resolution_clock::now();
-  // elapsed = end - start;
-  // // ,writetime\n
-  // oSS << "," << elapsed.count() << "\n";
-  // cout << oSS.str();
 
-  exit(EXIT_SUCCESS);
+  exit(lg->writeToRegion(region, groups) ? EXIT_SUCCESS : EXIT_FAILURE);
 }
 
+/**
+ * @brief Run every row of pySNN::data in a bounded set of forked children.
+ *
+ * Forks RuntimConfig::processes children (one per core if 0), never more than
+ * there are stimuli. The children share a counter in anonymous shared memory
+ * and each takes the next stimulus off it whenever it finishes one, so a
+ * batch of thousands of rows costs a handful of forks. Results come back
+ * through a ResultRegion per child, see SNN::forkRead.
+ */
 void pySNN::forkRun() {
   std::vector<pid_t> children;
-  std::vector<int *> pipes;
-
-  for (auto &v : data) {
-    dataToRun = v; // set the childs data
-    int *pipefd = (int *)malloc(sizeof(int) * 2);
-    int r = pipe(pipefd);
-    if (r == -1) {
-      lg->log(LogLevel::ERROR, "pySNN::forkRun: pipe failed to create pipe "
-                               "file descriptors, pipe() returned -1");
+  std::vector<ResultRegion *> regions;
+
+  prepareRun();
+
+  size_t number_children =
+      config->processes > 0 ? config->processes : sysconf(_SC_NPROCESSORS_ONLN);
+  number_children = std::min(number_children, data.rows());
+
+  void *shared = mmap(nullptr, sizeof(std::atomic<size_t>),
+                      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED) {
+    lg->log(LogLevel::ERROR, "pySNN::forkRun: failed to map the work queue, "
+                             "mmap() returned MAP_FAILED");
+    lg->string(LogLevel::ERROR, "erno reports %s", strerror(errno));
+    return;
+  }
+  std::atomic<size_t> *next = new (shared) std::atomic<size_t>(0);
+
+  for (size_t i = 0; i < number_children; i++) {
+    ResultRegion *region = new ResultRegion;
+    if (!region->create("snn-results")) {
+      lg->log(LogLevel::ERROR, "pySNN::forkRun: failed to create result "
+                               "region, memfd_create() returned -1");
       lg->string(LogLevel::ERROR, "erno reports %s", strerror(errno));
+      delete region;
+      continue;
     }
     pid_t cPID = fork();
     switch (cPID) {
-    case -1: // error state
+    case -1: // error state, the other children pick up the slack
       lg->log(LogLevel::ERROR,
               "pySNN::forkRun: failed to spawn child process, fork() "
               "returned -1");
       lg->string(LogLevel::ERROR, "erno reports %s", strerror(errno));
+      delete region;
       break;
-    case 0: {           // child process
-      close(pipefd[0]); // close the read end
-      runChildProcess(pipefd[1]);
+    case 0: // child process
+      for (ResultRegion *other : regions) {
+        other->close();
+      }
+      runChildProcess(*region, *next);
       break;
-    }
     default: // parent process
-
-      config->STIMULUS++; // this is so each child processes "config->STIMULUS"
-                          // references the right stimulus number
-      pipes.push_back(&pipefd[0]);
+      regions.push_back(region);
       children.push_back(cPID);
       break;
     }
   }
+  if (children.empty()) {
+    lg->log(LogLevel::ERROR, "pySNN::forkRun: no child process, batch NOT run");
+  }
+
   auto start = std::chrono::high_resolution_clock::now();
-  forkRead(children, pipes);
+  forkRead(children, regions);
   auto end = std::chrono::high_resolution_clock::now();
   std::chrono::duration<double> elapsed = end - start;
   std::cout << "forkread time elapsed is " << elapsed.count() << "\n";
+
+  munmap(shared, sizeof(std::atomic<size_t>));
 }
-void pySNN::runBatch(py::buffer &buff) {
-  processPyBuff(buff);
+/**
+ * @brief Run a batch in forked children, see pySNN::forkRun.
+ *
+ * The GIL is released once the buffer is taken, other Python threads (or
+ * another pySNN) keep running meanwhile.
+ *
+ * @param buff one row per stimulus, see pySNN::processPyBuff
+ * @param scale every element is multiplied by it
+ */
+void pySNN::runBatch(py::buffer &buff, double scale) {
+  finishAsync();
+  processPyBuff(buff, scale);
 
+  py::gil_scoped_release release;
   /*
    * Here we break the normal flow to update the configuration values based on
    * the passed buffer and dictionary
    */
   updateStimulusVectorToBuffDim();
+  prepareSink();
   forkRun();
 }
 
+/**
+ * @brief Like pySNN::runBatch, but return as soon as the batch started.
+ *
+ * The batch runs on a thread of its own. Python polls or waits for it through
+ * the returned handle and can load the next batch meanwhile. Calls reading
+ * the results, starting another run or changing the network wait for the
+ * batch to finish first.
+ *
+ * @return handle of the running batch
+ */
+std::shared_ptr<BatchRun> pySNN::runBatchAsync(py::buffer &buff,
+                                               double scale) {
+  finishAsync();
+  processPyBuff(buff, scale);
+  updateStimulusVectorToBuffDim();
+  prepareSink();
+
+  pending = std::make_shared<BatchRun>([this] { forkRun(); });
+  pending->start();
+  return pending;
+}
+
 void pySNN::pyStart() {
+  finishAsync();
+  py::gil_scoped_release release;
 
   /*
    * Here we break the normal flow to update the configuration values based on
    * the passed buffer and dictionary
    */
   updateStimulusVectorToBuffDim();
+  prepareSink();
 
+  prepareRun();
+  if (config->workers != 1) {
+    runPool(data);
+    return;
+  }
   pySetNextStim();
+  reset();
   generateInputNeuronEvents();
 
   if (config->show_stimulus) {
@@ -521,6 +834,7 @@ void pySNN::pyStart() {
     }
     for (auto group : groups) {
       pthread_join(group->getThreadID(), NULL);
+      group->transferData();
     }
     if (i < config->num_stimulus) {
       config->STIMULUS++;
@@ -532,11 +846,6 @@ void pySNN::pyStart() {
       generateInputNeuronEvents();
     }
   }
-  for (auto group : groups) {
-    for (auto n : group->getMutNeuronVec()) {
-      n->transferData();
-    }
-  }
 }
 
 template <typename T> void test(py::buffer buff) {
@@ -571,7 +880,7 @@ void pySNN::pySetNextStim() {
 
   for (std::vector<InputNeuron *>::size_type i = 0; i < input_neurons.size();
        i++) {
-    input_neurons.at(i)->setInputValue(data.at(*config->STIMULUS).at(i));
+    input_neurons.at(i)->setInputValue(data.at(*config->STIMULUS, i));
   }
 };
 
@@ -603,12 +912,73 @@ size_t bindex(size_t time_stamp, const std::vector<size_t> &thresholds) {
   return thresholds.size() - 1;
 }
 
+/**
+ * @brief Count activations as they happen instead of from the Log.
+ *
+ * Takes effect from the next pySNN.runBatch or pySNN.start, which allocate
+ * the counts for their stimuli. pySNN.getActivations, or
+ * pySNN.getIndividualActivations if `individual`, then return a view of the
+ * counts when called with the same number of bins.
+ *
+ * @param bins time bins, negative for one per timestamp, 0 to stop counting
+ * @param individual count every Neuron on its own
+ * @param keep_spikes log the activations as well, required for any other
+ * output
+ */
+void pySNN::setActivationSink(int bins, bool individual, bool keep_spikes) {
+  finishAsync();
+  sink_bins = bins;
+  sink_individual = individual;
+  sink_keep_spikes = keep_spikes;
+}
+
+/**
+ * @brief Allocate zeroed counts for the stimuli in pySNN::data.
+ */
+void pySNN::prepareSink() {
+  if (sink_bins == 0) {
+    setHistogram(nullptr);
+    return;
+  }
+  size_t time_bins =
+      sink_bins < 0 ? config->time_per_stimulus + 1 : sink_bins;
+  setHistogram(std::make_shared<ActivationHistogram>(
+                   data.rows(), sink_individual ? neurons.size() : 0,
+                   time_bins, config->time_per_stimulus),
+               sink_keep_spikes);
+}
+
+/**
+ * @brief Numpy array backed by the current ActivationHistogram, no copy.
+ *
+ * The array keeps the counts alive after the next batch replaces them.
+ */
+py::array_t<int> pySNN::sinkView() {
+  auto *owner = new std::shared_ptr<ActivationHistogram>(histogram);
+  py::capsule base(owner, [](void *p) {
+    delete static_cast<std::shared_ptr<ActivationHistogram> *>(p);
+  });
+  std::vector<py::ssize_t> shape = {
+      static_cast<py::ssize_t>(histogram->getNumberStimuli())};
+  if (histogram->isIndividual()) {
+    shape.push_back(histogram->getNumberNeurons());
+  }
+  shape.push_back(histogram->getBins());
+  return py::array_t<int>(shape, histogram->data(), base);
+}
+
 py::array_t<int> pySNN::getIndividualActivations(int bins) {
+  finishAsync();
   int activations = 0;
   size_t time_bins = bins < 0 ? config->time_per_stimulus + 1 : bins;
   size_t neuron_id = neurons.size();
   size_t num_stimulus = config->STIMULUS_VEC.size();
 
+  if (histogram && histogram->isValid() && histogram->isIndividual() &&
+      histogram->getBins() == time_bins) {
+    return sinkView();
+  }
+
   // cout << "time_bins: " << time_bins << "\n";
   // cout << "neuron_id: " << neurons.size() << "\n";
   // cout << "num_stimulus: " << config->STIMULUS_VEC.size() << "\n";
@@ -622,34 +992,112 @@ py::array_t<int> pySNN::getIndividualActivations(int bins) {
   // cout << "shape: (" << info.shape.at(0) << ", " << info.shape.at(1) << ", "
   //      << info.shape.at(2) << ")\n";
 
-  const std::vector<LogData *> &lg_data = lg->getLogData();
-
   const std::vector<size_t> thresholds =
       get_thresholds(time_bins, config->time_per_stimulus);
 
-  for (auto &data_point : lg_data) {
-    if (data_point->message_type == Message_t::Refractory) {
-      activations += 1;
-      size_t stim = data_point->stimulus_number;
-      size_t neuron = data_point->neuron_id;
-      size_t time_bin = bindex(data_point->timestamp, thresholds);
-      // cout << "stim " << stim << "\n";
-      // cout << "neuron: " << neuron << "\n";
-      // cout << "time_bin: " << time_bin << "\n";
-      // cout << "calc index: " << ret.index_at(stim, neuron, time_bin) <<
-      // "\n";
-      ret.mutable_at(stim, neuron, time_bin) += 1;
-    }
+  for (const SpikeRecord &spike : lg->getSpikes()) {
+    activations += 1;
+    size_t stim = spike.stimulus;
+    size_t neuron = spike.neuron;
+    size_t time_bin = bindex(spike.timestamp, thresholds);
+    // cout << "stim " << stim << "\n";
+    // cout << "neuron: " << neuron << "\n";
+    // cout << "time_bin: " << time_bin << "\n";
+    // cout << "calc index: " << ret.index_at(stim, neuron, time_bin) <<
+    // "\n";
+    ret.mutable_at(stim, neuron, time_bin) += 1;
   }
   // cout << "num activations = " << activations << "\n";
   return ret;
 }
 
+/**
+ * @brief Nonzero counts of pySNN.getIndividualActivations, in coordinate form.
+ *
+ * The dense `[stimulus x neuron x bin]` tensor is mostly zeros for large
+ * networks, this returns only the cells that fired, sorted by stimulus, then
+ * neuron, then bin. Built from the spikes in one pass plus a sort of their
+ * cell indices, or by scanning the ActivationHistogram when one counts
+ * individual neurons with the same bins. A CSR per stimulus follows from the
+ * order, `scipy.sparse.coo_matrix((count, (stimulus, neuron * bins + bin)))`
+ * gives one row per stimulus.
+ *
+ * @param bins time bins, negative for one per timestamp
+ * @return `(stimulus, neuron, bin, count)`, arrays of equal length
+ */
+py::tuple pySNN::getSparseIndividualActivations(int bins) {
+  finishAsync();
+  if (bins == 0) {
+    lg->log(ERROR, "pySNN::getSparseIndividualActivations: bins must not be 0");
+    throw std::runtime_error("");
+  }
+  size_t time_bins = bins < 0 ? config->time_per_stimulus + 1 : bins;
+  size_t number_neurons = neurons.size();
+  size_t num_stimulus = config->STIMULUS_VEC.size();
+  std::vector<uint64_t> cells;
+  std::vector<int> counts;
+
+  if (histogram && histogram->isValid() && histogram->isIndividual() &&
+      histogram->getBins() == time_bins) {
+    num_stimulus = histogram->getNumberStimuli();
+    const int *data = histogram->data();
+    size_t total = num_stimulus * number_neurons * time_bins;
+    for (size_t cell = 0; cell < total; cell++) {
+      if (data[cell]) {
+        cells.push_back(cell);
+        counts.push_back(data[cell]);
+      }
+    }
+  } else {
+    const TimeBins bin_of(time_bins, config->time_per_stimulus);
+    std::vector<uint64_t> keys;
+    keys.reserve(lg->getSpikes().size());
+    for (const SpikeRecord &spike : lg->getSpikes()) {
+      if (spike.stimulus >= num_stimulus || spike.neuron >= number_neurons) {
+        continue;
+      }
+      keys.push_back(
+          (uint64_t(spike.stimulus) * number_neurons + spike.neuron) *
+              time_bins +
+          bin_of(spike.timestamp));
+    }
+    std::sort(keys.begin(), keys.end());
+    for (uint64_t key : keys) {
+      if (!cells.empty() && cells.back() == key) {
+        counts.back() += 1;
+      } else {
+        cells.push_back(key);
+        counts.push_back(1);
+      }
+    }
+  }
+
+  py::ssize_t size = cells.size();
+  py::array_t<uint32_t> stimulus(size), neuron(size), bin(size);
+  py::array_t<int> count(size);
+  uint32_t *s = stimulus.mutable_data(), *n = neuron.mutable_data(),
+           *b = bin.mutable_data();
+  std::copy(counts.begin(), counts.end(), count.mutable_data());
+  for (py::ssize_t i = 0; i < size; i++) {
+    uint64_t row = cells[i] / time_bins;
+    b[i] = cells[i] % time_bins;
+    n[i] = row % number_neurons;
+    s[i] = row / number_neurons;
+  }
+  return py::make_tuple(stimulus, neuron, bin, count);
+}
+
 py::array_t<int> pySNN::getActivations(int bins) {
+  finishAsync();
   int activations = 0;
   size_t time_bins = bins < 0 ? config->time_per_stimulus + 1 : bins;
   size_t num_stimulus = config->STIMULUS_VEC.size();
 
+  if (histogram && histogram->isValid() && !histogram->isIndividual() &&
+      histogram->getBins() == time_bins) {
+    return sinkView();
+  }
+
   // cout << "time_bins: " << time_bins << "\n";
   // cout << "neuron_id: " << neurons.size() << "\n";
   // cout << "num_stimulus: " << config->STIMULUS_VEC.size() << "\n";
@@ -663,24 +1111,16 @@ py::array_t<int> pySNN::getActivations(int bins) {
   // cout << "shape: (" << info.shape.at(0) << ", " << info.shape.at(1) << ", "
   //      << info.shape.at(2) << ")\n";
 
-  const std::vector<LogData *> &lg_data = lg->getLogData();
-
   const std::vector<size_t> thresholds =
       get_thresholds(time_bins, config->time_per_stimulus);
 
-  for (auto &data_point : lg_data) {
-    if (data_point->message_type == Message_t::Refractory) {
-      activations += 1;
-      size_t stim = data_point->stimulus_number;
-      size_t neuron = data_point->neuron_id;
-      size_t time_bin = bindex(data_point->timestamp, thresholds);
-      // cout << "stim " << stim << "\n";
-      // cout << "neuron: " << neuron << "\n";
-      // cout << "time_bin: " << time_bin << "\n";
-      // cout << "calc index: " << ret.index_at(stim, neuron, time_bin) <<
-      // "\n";
-      ret.mutable_at(stim, time_bin) += 1;
-    }
+  for (const SpikeRecord &spike : lg->getSpikes()) {
+    activations += 1;
+    size_t stim = spike.stimulus;
+    size_t time_bin = bindex(spike.timestamp, thresholds);
+    // cout << "stim " << stim << "\n";
+    // cout << "time_bin: " << time_bin << "\n";
+    ret.mutable_at(stim, time_bin) += 1;
   }
   // cout << "num activations = " << activations << "\n";
   return ret;
@@ -745,15 +1185,22 @@ py::array_t<int> pySNN::getActivations(int bins) {
 //   return ret;
 // }
 
-void pySNN::pyWrite() { lg->writeData(); };
+void pySNN::pyWrite() {
+  finishAsync();
+  lg->writeData();
+};
 
 void pySNN::batchReset() {
+  finishAsync();
   reset();
   lg->batchReset();
-  data.clear();
+  data = InputMatrix();
+  data_view = py::buffer_info();
+  setHistogram(nullptr);
 }
 
 void pySNN::outputState() {
+  finishAsync();
   std::string underline(60, '=');
   std::cout << std::setw(30 - strlen("Python SNN State") / 2) << " ";
   std::cout << "Python SNN State\n";
@@ -770,26 +1217,47 @@ void pySNN::outputState() {
   std::cout << std::setw(35) << "Number of Edges: " << std::setw(10)
             << config->NUMBER_EDGES << "\n";
   std::cout << std::setw(35) << "Data dimensions: " << std::setw(10)
-            << data.size() << " stimulus, " << data.front().size()
+            << data.rows() << " stimulus, " << data.columns()
             << " inputs per stimulus" << "\n";
   std::cout << std::setw(35) << "Log size: " << std::setw(10)
-            << lg->getLogData().size() << "\n";
+            << lg->getSpikes().size() << "\n";
 }
 
 void pySNN::setProbabilityOfSuccess(double pSuccess) {
+  finishAsync();
   config->INPUT_PROB_SUCCESS = pSuccess;
 }
 
 void pySNN::setMaxLatency(double mLatency, bool update) {
+  finishAsync();
   config->max_latency = mLatency;
   if (update) {
     updateImage();
   }
 }
 
-void pySNN::setTau(double Tau) { config->TAU = Tau; }
+void pySNN::setTau(double Tau) {
+  finishAsync();
+  config->TAU = Tau;
+}
+
+void pySNN::setEngine(int engine) {
+  finishAsync();
+  config->engine = static_cast<Engine>(engine);
+}
+
+void pySNN::setWorkers(int workers) {
+  finishAsync();
+  config->workers = workers;
+}
+
+void pySNN::setProcesses(int processes) {
+  finishAsync();
+  config->processes = processes;
+}
 
 void pySNN::setRefractoryDuration(int refractory_duration, bool update) {
+  finishAsync();
   config->REFRACTORY_DURATION = refractory_duration;
   if (update) {
     updateNeuronParameters();
@@ -797,6 +1265,7 @@ void pySNN::setRefractoryDuration(int refractory_duration, bool update) {
 }
 
 void pySNN::setTimePerStimulus(int timePer) {
+  finishAsync();
   config->time_per_stimulus = timePer;
 }
 
@@ -806,24 +1275,33 @@ double pySNN::getMaxLatency() { return config->max_latency; }
 
 double pySNN::getTau() { return config->TAU; }
 
+int pySNN::getEngine() { return config->engine; }
+
+int pySNN::getWorkers() { return config->workers; }
+
+int pySNN::getProcesses() { return config->processes; }
+
 int pySNN::getRefractoryDuration() { return config->REFRACTORY_DURATION; }
 
 int pySNN::getTimePerStimulus() { return config->time_per_stimulus; }
 
 void pySNN::updateImage() {
+  finishAsync();
   image->max_latency = config->max_latency;
   setInputNeuronLatency();
 }
 
 void pySNN::setSeed(int seed) {
+  finishAsync();
   config->RAND_SEED = seed;
-  gen.seed(seed);
 }
 void pySNN::setInitialMembranePotential(double initialMembranePotential) {
+  finishAsync();
   config->INITIAL_MEMBRANE_POTENTIAL = initialMembranePotential;
 }
 void pySNN::setRefractoryMembranePotential(double refractoryMembranePotential,
                                            bool update) {
+  finishAsync();
   config->REFRACTORY_MEMBRANE_POTENTIAL = refractoryMembranePotential;
   if (update) {
     updateNeuronParameters();
@@ -841,6 +1319,7 @@ double pySNN::getRefractoryMembranePotential() {
 double pySNN::getActivationThreshold() { return config->ACTIVATION_THRESHOLD; }
 
 void pySNN::setActivationThreshold(double activationThreshold, bool update) {
+  finishAsync();
   config->ACTIVATION_THRESHOLD = activationThreshold;
   if (update) {
     updateNeuronParameters();
@@ -857,6 +1336,7 @@ void pySNN::setActivationThreshold(double activationThreshold, bool update) {
  *
  */
 void pySNN::updateNeuronParameters() {
+  finishAsync();
   for (auto &n : neurons) {
     n->setActivationThreshold(config->ACTIVATION_THRESHOLD);
     n->setRefractoryDuration(config->REFRACTORY_DURATION);
@@ -865,6 +1345,7 @@ void pySNN::updateNeuronParameters() {
 }
 
 void pySNN::updateConfig(ConfigDict dict) {
+  finishAsync();
   config->setOptions(dict);
 
   if (dict.at("activation_threshold") !=
@@ -1,7 +1,11 @@
 #include "../../extern/pybind/include/pybind11/numpy.h"
 #include "../../extern/pybind/include/pybind11/pybind11.h"
 #include "../network.hpp"
+#include <atomic>
+#include <functional>
 #include <map>
+#include <memory>
+#include <pthread.h>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -12,39 +16,100 @@ using AdjDict =
              std::map<std::tuple<int, int>, std::map<std::string, float>>>;
 
 typedef std::map<std::string, double> ConfigDict;
+typedef py::array_t<uint32_t, py::array::c_style | py::array::forcecast>
+    IndexArray;
+typedef py::array_t<double, py::array::c_style | py::array::forcecast>
+    WeightArray;
+typedef py::array_t<int, py::array::c_style | py::array::forcecast> DelayArray;
+
+/**
+ * @brief A batch running on a thread of its own, see pySNN::runBatchAsync.
+ *
+ * Python holds it as a handle to poll (BatchRun::done) or wait for
+ * (BatchRun::wait). The pySNN holds it too, and waits for it before anything
+ * else touches the network.
+ */
+class BatchRun {
+private:
+  std::function<void()> work;
+  pthread_t thread;
+  pthread_mutex_t join_tex = PTHREAD_MUTEX_INITIALIZER;
+  std::atomic<bool> finished{false};
+  bool joined = false;
+  std::string error; /**< what the run threw, empty if nothing */
+  bool raised = false; /**< error already raised by BatchRun::rethrow */
+
+  static void *thread_helper(void *instance);
+
+public:
+  explicit BatchRun(std::function<void()> work) : work(std::move(work)) {}
+  BatchRun(const BatchRun &) = delete;
+  BatchRun &operator=(const BatchRun &) = delete;
+  ~BatchRun();
+
+  void start();
+  void wait();
+  bool done() const { return finished.load(std::memory_order_acquire); }
+  void rethrow(bool unraised_only = false);
+};
 
 class pySNN : public SNN {
 private:
-  std::vector<std::vector<double>> data;
-  std::vector<double> dataToRun;
+  InputMatrix data;
+  py::buffer_info data_view; /**< keeps the array behind pySNN::data alive */
   AdjDict adjList;
-  size_t maxLayer; // maximum "layer", aka maximum number of columns
+  size_t maxLayer = 0; // maximum "layer", aka maximum number of columns
+  bool has_layout = false; /**< built from an AdjDict, maxLayer is valid */
   ConfigDict configDict;
+  int sink_bins = 0; /**< see pySNN::setActivationSink */
+  bool sink_individual = false;
+  bool sink_keep_spikes = true;
+  std::shared_ptr<BatchRun> pending; /**< see pySNN::runBatchAsync */
+
+  void prepareSink();
+  void finishAsync();
+  void generateNeurons(size_t numberNonInput);
+  size_t connectInputNeurons();
+  py::array_t<int> sinkView();
 
 public:
   pySNN(std::vector<std::string> args);
   pySNN(std::string configFile);
   pySNN(ConfigDict dict = {});
+  ~pySNN();
 
   static ConfigDict getDefaultConfig();
 
   void pyStart();
   void pySetNextStim();
   void pyWrite();
-  void initialize(AdjDict dict, py::buffer buff);
+  void initialize(AdjDict dict, py::buffer buff, double scale = 1.0);
   void initialize(AdjDict dict, size_t NUMBER_INPUT_NEURONS);
   void initialize(AdjDict &dict);
-  void runBatch(py::buffer &buff);
+  void initializeFromArrays(IndexArray src, IndexArray dst,
+                            WeightArray weight, DelayArray delay,
+                            size_t nInputNeurons, size_t numberNonInput = 0);
+  void runBatch(py::buffer &buff, double scale = 1.0);
+  std::shared_ptr<BatchRun> runBatchAsync(py::buffer &buff,
+                                          double scale = 1.0);
+  void generateSynapses();
   void updateEdgeWeights(AdjDict dict);
-  void processPyBuff(py::buffer &buff);
+  py::tuple getEdges();
+  py::array_t<double> getWeights();
+  py::array_t<int> getDelays();
+  void setWeights(WeightArray weights);
+  void setDelays(DelayArray delays);
+  void processPyBuff(py::buffer &buff, double scale = 1.0);
   void forkRun();
-  void runChildProcess(int fd);
+  void runChildProcess(ResultRegion &region, std::atomic<size_t> &next);
   void updateStimulusVectorToBuffDim();
   void generateImage();
-  void updateConfigToAdjList(const AdjDict &dict);
   void batchReset();
+  void setActivationSink(int bins, bool individual = false,
+                         bool keep_spikes = true);
   py::array_t<int> getActivations(int bins = -1);
   py::array_t<int> getIndividualActivations(int bins = -1);
+  py::tuple getSparseIndividualActivations(int bins = -1);
   void outputState();
 
   void updateImage();
@@ -55,6 +120,9 @@ public:
   void setProbabilityOfSuccess(double pSuccess);
   void setMaxLatency(double mLatency, bool update = true);
   void setTau(double Tau);
+  void setEngine(int engine);
+  void setWorkers(int workers);
+  void setProcesses(int processes);
   void setRefractoryDuration(int duration, bool update = true);
   void setTimePerStimulus(int timePerStimulus);
   void setSeed(int seed);
@@ -68,6 +136,9 @@ public:
   double getProbabilityOfSucess();
   double getMaxLatency();
   double getTau();
+  int getEngine();
+  int getWorkers();
+  int getProcesses();
   int getRefractoryDuration();
   int getTimePerStimulus();
   double getInitialMembranePotential();
@@ -82,30 +153,67 @@ PYBIND11_MODULE(snn, m) {
       .def("generateSynapses", &SNN::generateRandomSynapses)
       .def("start", &SNN::start)
       .def("join", &SNN::join);
+  py::class_<BatchRun, std::shared_ptr<BatchRun>>(m, "BatchRun")
+      .def("done", &BatchRun::done, "true once the batch has finished")
+      .def(
+          "result",
+          [](BatchRun &run) {
+            {
+              py::gil_scoped_release release;
+              run.wait();
+            }
+            run.rethrow();
+          },
+          "wait for the batch to finish, raises if it failed");
   py::class_<pySNN>(m, "pySNN")
       .def(py::init<std::vector<std::string>>())
       .def(py::init<std::string>(), py::arg("configFile") = "base_config.toml")
       .def(py::init<ConfigDict &>())
-      .def("generateSynapses", &pySNN::generateRandomSynapsesAdjMatrixGS,
+      .def("generateSynapses", &pySNN::generateSynapses,
            "Generate random neural connections")
       .def("updateSynapses", &pySNN::updateEdgeWeights,
            "Update edge weights based on dict of dicts")
+      .def("getEdges", &pySNN::getEdges,
+           "(src, dst) of every edge, in the order of getWeights/getDelays")
+      .def("getWeights", &pySNN::getWeights, "weight of every edge")
+      .def("setWeights", &pySNN::setWeights, py::arg("weights"),
+           "overwrite the weight of every edge")
+      .def("getDelays", &pySNN::getDelays, "delay of every edge")
+      .def("setDelays", &pySNN::setDelays, py::arg("delays"),
+           "overwrite the delay of every edge")
       .def("start", &pySNN::pyStart, "Start the neural network")
       .def("join", &SNN::join, "Wait for all threads to join")
       .def("writeData", &pySNN::pyWrite,
            "Write activation data to a file in ./logs")
       .def("getActivation", &pySNN::getActivations, py::arg("bins") = -1,
            "Get the activation data in the form of a numpy array")
+      .def("setActivationSink", &pySNN::setActivationSink, py::arg("bins"),
+           py::arg("individual") = false, py::arg("keep_spikes") = true,
+           "count activations into bins as neurons fire, 0 bins to stop")
       .def("getIndividualActivation", &pySNN::getIndividualActivations,
            py::arg("bins") = -1,
            "Get the activation data for individual neurons in the form of a "
            "numpy tensor")
+      .def("getSparseIndividualActivation",
+           &pySNN::getSparseIndividualActivations, py::arg("bins") = -1,
+           "Get the nonzero activation counts of individual neurons as "
+           "(stimulus, neuron, bin, count) arrays")
       .def("initialize",
-           py::overload_cast<AdjDict, py::buffer>(&pySNN::initialize),
+           py::overload_cast<AdjDict, py::buffer, double>(&pySNN::initialize),
+           py::arg("dict"), py::arg("buff"), py::arg("scale") = 1.0,
            "Initilize network from dict of dicts")
       .def("initialize", py::overload_cast<AdjDict, size_t>(&pySNN::initialize),
            "Initilize network from dict of dicts")
-      .def("runBatch", &pySNN::runBatch, "Run a batch in a child process")
+      .def("initializeFromArrays", &pySNN::initializeFromArrays,
+           py::arg("src"), py::arg("dst"), py::arg("weight"), py::arg("delay"),
+           py::arg("n_input"), py::arg("n_neurons") = 0,
+           "Initialize network from an edge list in numpy arrays")
+      .def("runBatch", &pySNN::runBatch, py::arg("buff"),
+           py::arg("scale") = 1.0,
+           "Run a batch of float64, float32 or uint8 rows, times scale")
+      .def("runBatchAsync", &pySNN::runBatchAsync, py::arg("buff"),
+           py::arg("scale") = 1.0,
+           "Start runBatch on another thread and return a BatchRun handle")
       .def("batchReset", &pySNN::batchReset, "Reset network after a batch run")
       .def("outputState", &pySNN::outputState, "Output state")
       .def_static("getDefaultConfig", &pySNN::getDefaultConfig,
@@ -116,6 +224,12 @@ PYBIND11_MODULE(snn, m) {
       .def("setMaxLatency", &pySNN::setMaxLatency, py::arg("mLatency"),
            py::arg("update") = true, "")
       .def("setTau", &pySNN::setTau, "")
+      .def("setEngine", &pySNN::setEngine, py::arg("engine"),
+           "0 runs messages one by one, 1 a tick at a time")
+      .def("setWorkers", &pySNN::setWorkers, py::arg("workers"),
+           "stimuli run at once by pySNN.start, 0 for one per core")
+      .def("setProcesses", &pySNN::setProcesses, py::arg("processes"),
+           "children forked by pySNN.runBatch, 0 for one per core")
       .def("setRefractoryDuration", &pySNN::setRefractoryDuration, "")
       .def("setTimePerStimulus", &pySNN::setTimePerStimulus, "")
       .def("setSeed", &pySNN::setSeed, "")
@@ -129,6 +243,9 @@ PYBIND11_MODULE(snn, m) {
       .def("getProbabilityOfSucess", &pySNN::getProbabilityOfSucess, "")
       .def("getMaxLatency", &pySNN::getMaxLatency, "")
       .def("getTau", &pySNN::getTau, "")
+      .def("getEngine", &pySNN::getEngine, "")
+      .def("getWorkers", &pySNN::getWorkers, "")
+      .def("getProcesses", &pySNN::getProcesses, "")
       .def("getRefractoryDuration", &pySNN::getRefractoryDuration, "")
       .def("getTimePerStimulus", &pySNN::getTimePerStimulus, "")
       .def("getInitialMembranePotential", &pySNN::getInitialMembranePotential,
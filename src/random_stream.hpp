@@ -0,0 +1,108 @@
+/** @file */
+#ifndef RANDOM_STREAM
+#define RANDOM_STREAM
+
+#include <cstdint>
+
+/**
+ * \enum Random_t
+ * @brief What a RandomStream is drawn for.
+ *
+ * Part of the key, so streams for different purposes never overlap even when
+ * their ids are the same.
+ */
+enum Random_t : uint32_t {
+  Layout = 0,     /**< input or regular roll of a group's Neurons */
+  Synapses = 1,   /**< edges picked by the random synapse generators */
+  Edge = 2,       /**< weight and delay of one edge */
+  Intergroup = 3, /**< intergroup edges of generateRandomSynapsesAdjMatrixGS */
+  Timestamps = 4, /**< input timestamps of a stimulus */
+};
+
+/**
+ * @brief Counter based random numbers (Philox4x32-10).
+ *
+ * A draw is a pure function of the key and a counter: the key holds
+ * RuntimConfig::RAND_SEED and the Random_t, the counter holds the block
+ * number and up to three ids (e.g. stimulus, group and Neuron). Every block
+ * gives four draws. Any thread or forked child can therefore construct the
+ * stream it needs and get the same numbers without sharing or locking
+ * generator state, independent of how the work is split up.
+ *
+ * Also a UniformRandomBitGenerator, but RandomStream::uniform and
+ * RandomStream::below are preferred over the `<random>` distributions, whose
+ * output is not the same across standard libraries.
+ */
+class RandomStream {
+public:
+  typedef uint32_t result_type;
+
+  RandomStream(int seed, Random_t purpose, uint32_t a = 0, uint32_t b = 0,
+               uint32_t c = 0)
+      : key{static_cast<uint32_t>(seed), purpose}, ids{a, b, c} {}
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return UINT32_MAX; }
+
+  result_type operator()() {
+    uint32_t block = static_cast<uint32_t>(position / 4);
+    if (block != cached || !filled) {
+      words[0] = block;
+      words[1] = ids[0];
+      words[2] = ids[1];
+      words[3] = ids[2];
+      philox(words, key);
+      cached = block;
+      filled = true;
+    }
+    return words[position++ % 4];
+  }
+
+  /** @brief Skip `n` draws. */
+  void discard(uint64_t n) { position += n; }
+
+  /** @brief Uniform in [0, 1) with 32 bits of resolution. */
+  double uniform() { return (*this)() * (1.0 / 4294967296.0); }
+
+  /** @brief Uniform in [0, n), n > 0. */
+  uint32_t below(uint32_t n) {
+    return static_cast<uint32_t>((static_cast<uint64_t>((*this)()) * n) >> 32);
+  }
+
+  /**
+   * @brief One Philox4x32-10 block.
+   *
+   * @param counter replaced by the output
+   * @param key two key words
+   */
+  static void philox(uint32_t counter[4], const uint32_t key[2]) {
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+    for (int round = 0; round < 10; round++) {
+      uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * counter[0];
+      uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * counter[2];
+      uint32_t out[4] = {
+          static_cast<uint32_t>(p1 >> 32) ^ counter[1] ^ k0,
+          static_cast<uint32_t>(p1),
+          static_cast<uint32_t>(p0 >> 32) ^ counter[3] ^ k1,
+          static_cast<uint32_t>(p0),
+      };
+      counter[0] = out[0];
+      counter[1] = out[1];
+      counter[2] = out[2];
+      counter[3] = out[3];
+      k0 += 0x9E3779B9u;
+      k1 += 0xBB67AE85u;
+    }
+  }
+
+private:
+  uint32_t key[2];
+  uint32_t ids[3];
+  uint64_t position = 0; /**< number of the next draw */
+  uint32_t cached = 0;   /**< block held in RandomStream::words */
+  bool filled = false;
+  uint32_t words[4];
+};
+
+#endif // !RANDOM_STREAM
@@ -0,0 +1,102 @@
+#include "result_region.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+ResultRegion::~ResultRegion() { close(); }
+
+/**
+ * @brief Create the anonymous file, right before forking its child.
+ *
+ * The file is close-on-exec. Other children forked later inherit it too and
+ * close it themselves, see ResultRegion::close.
+ *
+ * @param name shows up in /proc/<pid>/fd, for debugging only
+ * @return false if memfd_create failed, errno is left as is
+ */
+bool ResultRegion::create(const char *name) {
+  close();
+  fd = memfd_create(name, MFD_CLOEXEC);
+  return fd != -1;
+}
+
+/**
+ * @brief Size and map the region for `count` records, child side.
+ *
+ * @return where the records go, nullptr on failure
+ */
+SpikeRecord *ResultRegion::reserve(size_t count) {
+  size_t size = sizeof(Header) + count * sizeof(SpikeRecord);
+  if (ftruncate(fd, size) == -1) {
+    return nullptr;
+  }
+  void *mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mem == MAP_FAILED) {
+    return nullptr;
+  }
+  base = mem;
+  length = size;
+  return reinterpret_cast<SpikeRecord *>(static_cast<Header *>(base) + 1);
+}
+
+/**
+ * @brief Publish the header once the records are written, child side.
+ */
+void ResultRegion::commit(size_t count) {
+  Header *header = static_cast<Header *>(base);
+  header->count = count;
+  header->complete = 1;
+  munmap(base, length);
+  base = nullptr;
+  length = 0;
+}
+
+/**
+ * @brief Map what the child wrote, parent side, after the child exited.
+ *
+ * @return false if the child left nothing (it failed before
+ * ResultRegion::reserve) or mapping failed
+ */
+bool ResultRegion::map() {
+  struct stat st;
+  if (fstat(fd, &st) == -1 ||
+      static_cast<size_t>(st.st_size) < sizeof(Header)) {
+    return false;
+  }
+  void *mem = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (mem == MAP_FAILED) {
+    return false;
+  }
+  base = mem;
+  length = st.st_size;
+  return true;
+}
+
+const SpikeRecord *ResultRegion::records() const {
+  return reinterpret_cast<const SpikeRecord *>(
+      static_cast<const Header *>(base) + 1);
+}
+
+size_t ResultRegion::count() const {
+  const Header *header = static_cast<const Header *>(base);
+  if (!header->complete) {
+    return 0;
+  }
+  size_t fits = (length - sizeof(Header)) / sizeof(SpikeRecord);
+  return header->count < fits ? header->count : fits;
+}
+
+/**
+ * @brief Unmap and close the file.
+ */
+void ResultRegion::close() {
+  if (base) {
+    munmap(base, length);
+    base = nullptr;
+    length = 0;
+  }
+  if (fd != -1) {
+    ::close(fd);
+    fd = -1;
+  }
+}
@@ -0,0 +1,52 @@
+/** @file */
+#ifndef RESULT_REGION
+#define RESULT_REGION
+
+#include "log.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Shared memory a forked child hands its activations back through.
+ *
+ * The parent creates one region per child right before forking it, the child
+ * inherits the anonymous file (memfd), closes the regions of the children
+ * forked before it and, once its stimuli are done, sizes it to its
+ * activations and writes them as a ResultRegion::Header followed by
+ * `SpikeRecord`s (Log::writeToRegion). After the child exits the parent maps
+ * the file and hands the records to Log::addSpikes in one go, instead of one
+ * `read()` and one `new` per record.
+ */
+class ResultRegion {
+public:
+  struct Header {
+    uint64_t count;    /**< number of SpikeRecord following the header */
+    uint32_t complete; /**< set last by the child */
+    uint32_t reserved;
+  };
+
+private:
+  int fd = -1;
+  void *base = nullptr;
+  size_t length = 0;
+
+public:
+  ResultRegion() = default;
+  ResultRegion(const ResultRegion &) = delete;
+  ResultRegion &operator=(const ResultRegion &) = delete;
+  ~ResultRegion();
+
+  bool create(const char *name);
+  SpikeRecord *reserve(size_t count);
+  void commit(size_t count);
+  bool map();
+  void close();
+
+  bool isOpen() const { return fd != -1; }
+  /** Records of a mapped region, see ResultRegion::map */
+  const SpikeRecord *records() const;
+  /** Number of records of a mapped region, 0 if the child never finished */
+  size_t count() const;
+};
+
+#endif // !RESULT_REGION
@@ -11,9 +11,7 @@ extern Log lg;
  * @brief Destroy all mutexes in use.
  */
 void Mutex::destroy_mutexes() {
-  pthread_mutex_destroy(&potential);
   pthread_mutex_destroy(&log);
-  pthread_mutex_destroy(&message);
   pthread_mutex_destroy(&activation);
   pthread_mutex_destroy(&stimulus);
 }
@@ -28,6 +26,9 @@ void RuntimConfig::setOptions(std::map<std::string, double> &dict) {
   ACTIVATION_THRESHOLD = dict.at("activation_threshold");
   REFRACTORY_MEMBRANE_POTENTIAL = dict.at("refractory_membrane_potential");
   TAU = dict.at("tau");
+  decay_mode = dict.count("decay_mode")
+                   ? static_cast<DecayMode>(dict.at("decay_mode"))
+                   : DecayMode::ClosedForm;
   max_latency = dict.at("max_latency");
   max_synapse_delay = dict.at("max_synapse_delay");
   min_synapse_delay = dict.at("min_synapse_delay");
@@ -36,6 +37,11 @@ void RuntimConfig::setOptions(std::map<std::string, double> &dict) {
   DEBUG_LEVEL = static_cast<LogLevel>(dict.at("debug_level"));
   LIMIT_LOG_OUTPUT = dict.at("limit_log_size");
   show_stimulus = dict.at("show_stimulus");
+  engine = dict.count("engine") ? static_cast<Engine>(dict.at("engine"))
+                                : Engine::EventDriven;
+  workers = dict.count("workers") ? static_cast<int>(dict.at("workers")) : 1;
+  processes =
+      dict.count("processes") ? static_cast<int>(dict.at("processes")) : 0;
   time_per_stimulus = dict.at("time_per_stimulus");
 
   hr_clock::time_point now = hr_clock::now();
@@ -95,6 +101,10 @@ void RuntimConfig::generateNewConfig() {
   file << "#  tau for the linearlization of the decay function\n";
   file << "tau = 100.0\n";
   file << '\n';
+  file << "#  decay computation, \"closed_form\" or \"reference\" (step by "
+          "step)\n";
+  file << "decay = \"closed_form\"\n";
+  file << '\n';
   file << "#  Maximum latency for input neurons\n";
   file << "max_latency = 5\n";
   file << '\n';
@@ -134,6 +144,13 @@ void RuntimConfig::generateNewConfig() {
   file << "# Show the current stimlus number" << '\n';
   file << "show_stimulus = false" << '\n';
   file << '\n';
+  file << "# \"event\" runs messages one by one, \"clock\" a tick at a time"
+       << '\n';
+  file << "engine = \"event\"" << '\n';
+  file << '\n';
+  file << "# stimuli run at once in-process, 0 for one per core" << '\n';
+  file << "workers = 1" << '\n';
+  file << '\n';
   file << "# simulated time per stimulus in \"ms\"" << '\n';
   file << "time_per_stimulus = 250" << '\n';
   file << '\n';
@@ -221,6 +238,23 @@ int RuntimConfig::setOptions() {
     snn->lg->string(ERROR, "Failed to parse: %s", "tau");
   }
 
+  if (tbl["neuron"]["decay"].as_string()) {
+    std::string mode = tbl["neuron"]["decay"].as_string()->get();
+    if (mode == "reference") {
+      decay_mode = DecayMode::Reference;
+    } else {
+      if (mode != "closed_form") {
+        snn->lg->string(ERROR, "Unknown decay \"%s\", using closed_form",
+                        mode.c_str());
+      }
+      decay_mode = DecayMode::ClosedForm;
+    }
+  } else {
+    snn->lg->string(ERROR, "Failed to parse: %s, using default option: "
+                    "closed_form", "decay");
+    decay_mode = DecayMode::ClosedForm;
+  }
+
   if (tbl["neuron"]["input_neuron_count"].as_integer()) {
     NUMBER_INPUT_NEURONS =
         tbl["neuron"]["input_neuron_count"].as_integer()->get();
@@ -280,6 +314,31 @@ int RuntimConfig::setOptions() {
     show_stimulus = true;
   }
 
+  if (tbl["runtime_vars"]["engine"].as_string()) {
+    std::string name = tbl["runtime_vars"]["engine"].as_string()->get();
+    if (name == "clock") {
+      engine = Engine::ClockDriven;
+    } else {
+      if (name != "event") {
+        snn->lg->string(ERROR, "Unknown engine \"%s\", using event",
+                        name.c_str());
+      }
+      engine = Engine::EventDriven;
+    }
+  } else {
+    snn->lg->string(ERROR, "Failed to parse: %s, using default option: event",
+                    "engine");
+    engine = Engine::EventDriven;
+  }
+
+  if (tbl["runtime_vars"]["workers"].as_integer()) {
+    workers = tbl["runtime_vars"]["workers"].as_integer()->get();
+  } else {
+    snn->lg->string(ERROR, "Failed to parse: %s, using default option: 1",
+                    "workers");
+    workers = 1;
+  }
+
   if (tbl["runtime_vars"]["time_per_stimulus"].as_integer()) {
     time_per_stimulus =
         tbl["runtime_vars"]["time_per_stimulus"].as_integer()->get();
@@ -291,9 +350,15 @@ int RuntimConfig::setOptions() {
     std::string seed = tbl["random"]["seed"].as_string()->get();
     if (seed == "time") {
       RAND_SEED = time(0);
-    } else if (tbl["random"]["seed"].as_integer()) {
-      RAND_SEED = tbl["random"]["seed"].as_integer()->get();
+    } else {
+      try {
+        RAND_SEED = std::stoi(seed);
+      } catch (const std::logic_error &) {
+        snn->lg->string(ERROR, "Failed to parse: %s", "random seed");
+      }
     }
+  } else if (tbl["random"]["seed"].as_integer()) {
+    RAND_SEED = tbl["random"]["seed"].as_integer()->get();
   } else {
     snn->lg->string(ERROR, "Failed to parse: %s", "random seed");
   }
@@ -14,16 +14,26 @@ public:
   void destroy_mutexes();
   // Protects Stimulus
   pthread_mutex_t stimulus = PTHREAD_MUTEX_INITIALIZER;
-  // Protects the membrane_potential
-  pthread_mutex_t potential = PTHREAD_MUTEX_INITIALIZER;
   // Protects output stream
   pthread_mutex_t log = PTHREAD_MUTEX_INITIALIZER;
   // Protects activation
   pthread_mutex_t activation = PTHREAD_MUTEX_INITIALIZER;
-  // Protects messaging
-  pthread_mutex_t message = PTHREAD_MUTEX_INITIALIZER;
 };
 
+/**
+ * \enum DecayMode
+ * How NeuronGroup::retroactiveDecay computes the membrane potential decay.
+ * See DecayTable.
+ */
+enum DecayMode { ClosedForm = 0, Reference = 1 };
+
+/**
+ * \enum Engine
+ * How a NeuronGroup runs its messages, one at a time (NeuronGroup::runNeuron)
+ * or a tick at a time (TickEngine).
+ */
+enum Engine { EventDriven = 0, ClockDriven = 1 };
+
 /**
  * @brief Holds all configuration options.
  *
@@ -90,6 +100,10 @@ public:
  * [runtime_vars]
  * # in seconds
  * runtime = 20
+ * # "event" runs messages one by one, "clock" a tick at a time
+ * engine = "event"
+ * # stimuli run at once in-process, 0 for one per core
+ * workers = 1
  * # file to read input from
  * input_file = "./input_files/test"
  * # format should be "x..y" for reading lines x to y (inclusive) or just x for
@@ -115,6 +129,10 @@ struct RuntimConfig {
   bool LIMIT_LOG_OUTPUT;
   bool show_stimulus;
   double TAU;
+  DecayMode decay_mode;
+  Engine engine;
+  int workers; /**< stimuli run at once by a StimulusPool, 0 for one per core */
+  int processes; /**< children forked by pySNN::runBatch, 0 for one per core */
   int REFRACTORY_DURATION;
   double DECAY_VALUE;
   double INPUT_PROB_SUCCESS;
@@ -0,0 +1,65 @@
+/** @file */
+#ifndef SPIKE_BUFFER
+#define SPIKE_BUFFER
+
+#include "log.hpp"
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Append-only buffer of `SpikeRecord`s, filled by one thread.
+ *
+ * Records go into fixed size chunks, so a full chunk is never copied when the
+ * buffer grows. SpikeBuffer::clear keeps the chunks, a buffer that is emptied
+ * after every stimulus stops allocating once it has grown to the busiest
+ * stimulus.
+ */
+class SpikeBuffer {
+private:
+  static constexpr size_t chunk_size = 4096;
+  std::vector<std::vector<SpikeRecord>> chunks;
+  size_t current = 0; /**< chunk being filled */
+
+public:
+  void push(const SpikeRecord &spike) {
+    if (current == chunks.size()) {
+      chunks.emplace_back();
+      chunks.back().reserve(chunk_size);
+    }
+    chunks[current].push_back(spike);
+    if (chunks[current].size() == chunk_size) {
+      current++;
+    }
+  }
+
+  /**
+   * @brief Hand every non-empty chunk to `f(records, count)`, in push order.
+   */
+  template <typename F> void forEachChunk(F f) const {
+    for (const auto &chunk : chunks) {
+      if (!chunk.empty()) {
+        f(chunk.data(), chunk.size());
+      }
+    }
+  }
+
+  size_t size() const {
+    size_t count = 0;
+    for (const auto &chunk : chunks) {
+      count += chunk.size();
+    }
+    return count;
+  }
+
+  /**
+   * @brief Drop every record, keeping the chunks for reuse.
+   */
+  void clear() {
+    for (auto &chunk : chunks) {
+      chunk.clear();
+    }
+    current = 0;
+  }
+};
+
+#endif // !SPIKE_BUFFER
@@ -0,0 +1,86 @@
+/** @file */
+#ifndef SPSC_RING
+#define SPSC_RING
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Bounded single producer, single consumer ring buffer.
+ *
+ * Carries the Messages of one intergroup link (NeuronGroup::deliver): only the
+ * sending group's thread pushes and only the receiving group's thread pops, so
+ * the two ends synchronize through a pair of atomic indices instead of a
+ * mutex. The indices live on separate cache lines so the producer and the
+ * consumer do not false-share.
+ *
+ * SpscRing::push fails when the ring is full, the caller decides how to wait.
+ */
+template <typename T> class SpscRing {
+private:
+  std::vector<T> slots;
+  size_t mask;
+  alignas(64) std::atomic<size_t> head{0}; /**< next slot to pop */
+  alignas(64) std::atomic<size_t> tail{0}; /**< next slot to push */
+
+public:
+  /**
+   * @param capacity rounded up to a power of 2
+   */
+  SpscRing(size_t capacity = 4096) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    slots.resize(size);
+    mask = size - 1;
+  }
+  SpscRing(const SpscRing &) = delete;
+  SpscRing &operator=(const SpscRing &) = delete;
+
+  /**
+   * @brief Append a value, producer side only.
+   *
+   * @return false if the ring is full
+   */
+  bool push(const T &value) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == slots.size()) {
+      return false;
+    }
+    slots[t & mask] = value;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Hand every queued value to `f` in push order, consumer side only.
+   *
+   * @return number of values consumed
+   */
+  template <typename F> size_t drain(F f) {
+    size_t h = head.load(std::memory_order_relaxed);
+    size_t t = tail.load(std::memory_order_acquire);
+    for (size_t i = h; i != t; i++) {
+      f(slots[i & mask]);
+    }
+    head.store(t, std::memory_order_release);
+    return t - h;
+  }
+
+  bool empty() const {
+    return head.load(std::memory_order_acquire) ==
+           tail.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Drop every value, neither end may be in use.
+   */
+  void clear() {
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+  }
+};
+
+#endif // !SPSC_RING
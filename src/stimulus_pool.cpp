@@ -0,0 +1,225 @@
+#include "stimulus_pool.hpp"
+#include "input_neuron.hpp"
+#include "log.hpp"
+#include "network.hpp"
+#include "neuron_group.hpp"
+#include "runtime.hpp"
+#include <climits>
+#include <cstdlib>
+
+/**
+ * @brief Start `number_workers` workers, each with a replica of the network.
+ *
+ * @param network SNN whose groups are replicated
+ * @param number_workers number of threads
+ */
+StimulusPool::StimulusPool(SNN *network, int number_workers)
+    : network(network) {
+  const std::vector<NeuronGroup *> &groups = network->getGroups();
+  for (int i = 0; i < number_workers; i++) {
+    Worker *worker = new Worker;
+    worker->pool = this;
+    for (auto group : groups) {
+      worker->replica.push_back(new NeuronGroup(group, &worker->replica));
+    }
+    workers.push_back(worker);
+  }
+  for (auto worker : workers) {
+    pthread_create(&worker->thread, NULL, StimulusPool::thread_helper, worker);
+  }
+}
+
+/**
+ * @brief Stop and join every worker.
+ */
+StimulusPool::~StimulusPool() {
+  pthread_mutex_lock(&tex);
+  stopping = true;
+  pthread_cond_broadcast(&start_cond);
+  pthread_mutex_unlock(&tex);
+
+  for (auto worker : workers) {
+    pthread_join(worker->thread, NULL);
+    for (auto group : worker->replica) {
+      delete group;
+    }
+    pthread_mutex_destroy(&worker->tasks_tex);
+    delete worker;
+  }
+  pthread_mutex_destroy(&tex);
+  pthread_cond_destroy(&start_cond);
+  pthread_cond_destroy(&done_cond);
+}
+
+/**
+ * @brief Run every stimulus and wait for all of them to finish.
+ *
+ * Replicas pick up the current parameters (thresholds, refractory durations
+ * and potentials) of their prototype groups first. SNN::prepareRun must have
+ * been called.
+ *
+ * @param stimulus_numbers number each stimulus is logged with
+ * @param stimulus_inputs value of every InputNeuron (in SNN order) per
+ * stimulus
+ */
+void StimulusPool::run(const std::vector<int> &stimulus_numbers,
+                       const InputMatrix &stimulus_inputs) {
+  for (auto worker : workers) {
+    for (auto group : worker->replica) {
+      group->getState() = group->getPrototype()->getState();
+    }
+  }
+
+  pthread_mutex_lock(&tex);
+  numbers = &stimulus_numbers;
+  inputs = &stimulus_inputs;
+  remaining = stimulus_numbers.size();
+  pthread_mutex_unlock(&tex);
+
+  // a worker still looking for work from the last run may steal these right
+  // away, which is fine since the run is already set up
+  for (size_t task = 0; task < stimulus_numbers.size(); task++) {
+    Worker *worker = workers[task % workers.size()];
+    pthread_mutex_lock(&worker->tasks_tex);
+    worker->tasks.push_back(task);
+    pthread_mutex_unlock(&worker->tasks_tex);
+  }
+
+  pthread_mutex_lock(&tex);
+  generation++;
+  pthread_cond_broadcast(&start_cond);
+  while (remaining) {
+    pthread_cond_wait(&done_cond, &tex);
+  }
+  pthread_mutex_unlock(&tex);
+}
+
+/**
+ * @brief Take the next task of `worker`, stealing one if it has none left.
+ *
+ * @return false once every deque is empty
+ */
+bool StimulusPool::takeTask(Worker *worker, size_t &task) {
+  pthread_mutex_lock(&worker->tasks_tex);
+  bool found = !worker->tasks.empty();
+  if (found) {
+    task = worker->tasks.back();
+    worker->tasks.pop_back();
+  }
+  pthread_mutex_unlock(&worker->tasks_tex);
+  if (found) {
+    return true;
+  }
+
+  for (auto victim : workers) {
+    if (victim == worker) {
+      continue;
+    }
+    pthread_mutex_lock(&victim->tasks_tex);
+    found = !victim->tasks.empty();
+    if (found) {
+      task = victim->tasks.front();
+      victim->tasks.pop_front();
+    }
+    pthread_mutex_unlock(&victim->tasks_tex);
+    if (found) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Run one stimulus on the replica of `worker`.
+ *
+ * Generates the input events the way SNN::generateInputNeuronEvents does after
+ * SNN::reset, runs every group of the replica a tick at a time and moves the
+ * activations into the Log.
+ */
+void StimulusPool::runStimulus(Worker *worker, size_t task) {
+  std::vector<NeuronGroup *> &replica = worker->replica;
+
+  for (auto group : replica) {
+    group->reset();
+    group->setStimulus((*numbers)[task]);
+  }
+
+  std::vector<int> timestamps = network->stimulusTimestamps((*numbers)[task]);
+
+  for (auto group : replica) {
+    group->clearStimulus();
+  }
+  std::vector<InputNeuron *> &input_neurons = network->getMutInputNeurons();
+  for (size_t i = 0; i < input_neurons.size(); i++) {
+    double input = inputs->at(task, i);
+    if (input < 0.00001) {
+      continue;
+    }
+    NeuronGroup *into = replica[input_neurons[i]->getGroup()->getID() - 1];
+    input_neurons[i]->joinStimulus(input, into);
+  }
+  for (auto group : replica) {
+    group->queueStimulus(timestamps);
+  }
+
+  // step every group through the ticks in order, messages between groups
+  // always land in a later tick (or the one being run, which is revisited)
+  while (true) {
+    int timestamp = INT_MAX;
+    for (auto group : replica) {
+      if (group->hasMessages() && group->nextTimestamp() < timestamp) {
+        timestamp = group->nextTimestamp();
+      }
+    }
+    if (timestamp == INT_MAX) {
+      break;
+    }
+    for (auto group : replica) {
+      if (group->hasMessages() && group->nextTimestamp() == timestamp) {
+        group->runTick(timestamp);
+      }
+    }
+  }
+
+  pthread_mutex_lock(&network->getMutex()->log);
+  for (auto group : replica) {
+    network->lg->addSpikes(group->getActivations());
+    group->getActivations().clear();
+  }
+  pthread_mutex_unlock(&network->getMutex()->log);
+}
+
+/**
+ * @brief Worker loop: wait for a run, drain tasks, report back.
+ */
+void StimulusPool::work(Worker *worker) {
+  while (true) {
+    pthread_mutex_lock(&tex);
+    while (!stopping && worker->generation == generation) {
+      pthread_cond_wait(&start_cond, &tex);
+    }
+    if (stopping) {
+      pthread_mutex_unlock(&tex);
+      return;
+    }
+    worker->generation = generation;
+    pthread_mutex_unlock(&tex);
+
+    size_t task;
+    while (takeTask(worker, task)) {
+      runStimulus(worker, task);
+
+      pthread_mutex_lock(&tex);
+      if (--remaining == 0) {
+        pthread_cond_signal(&done_cond);
+      }
+      pthread_mutex_unlock(&tex);
+    }
+  }
+}
+
+void *StimulusPool::thread_helper(void *instance) {
+  Worker *worker = static_cast<Worker *>(instance);
+  worker->pool->work(worker);
+  return nullptr;
+}
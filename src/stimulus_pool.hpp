@@ -0,0 +1,72 @@
+/** @file */
+#ifndef STIMULUS_POOL
+#define STIMULUS_POOL
+
+#include "input_matrix.hpp"
+#include <deque>
+#include <pthread.h>
+#include <vector>
+
+class SNN;
+class NeuronGroup;
+
+/**
+ * @brief Persistent worker pool running many stimuli of one SNN at once.
+ *
+ * Every worker owns a replica of all `NeuronGroup`s (see the replica
+ * constructor of NeuronGroup): its own NeuronState, message queues and
+ * activation buffers, sharing the `Neuron`s and the frozen SynapseGraph of the
+ * SNN. A stimulus runs on one worker from start to finish, with the groups of
+ * the replica stepped tick by tick on that worker's thread.
+ *
+ * StimulusPool::run deals the stimuli round robin onto per worker deques. A
+ * worker takes from the back of its own deque and, once it is empty, steals
+ * from the front of the others. Activations of a finished stimulus are moved
+ * straight into the SNN's Log.
+ *
+ * Every stimulus starts from a reset network and draws its input timestamps
+ * from its own RandomStream (SNN::stimulusTimestamps), like the stimuli of
+ * SNN::start, so the results do not depend on which worker runs a stimulus or
+ * in what order.
+ */
+class StimulusPool {
+private:
+  struct Worker {
+    StimulusPool *pool;
+    pthread_t thread;
+    pthread_mutex_t tasks_tex = PTHREAD_MUTEX_INITIALIZER;
+    std::deque<size_t> tasks; /**< positions in StimulusPool::numbers */
+    std::vector<NeuronGroup *> replica; /**< by group ID - 1 */
+    unsigned int generation = 0; /**< last run this worker joined */
+  };
+
+  SNN *network;
+  std::vector<Worker *> workers;
+
+  // current run, guarded by tex
+  pthread_mutex_t tex = PTHREAD_MUTEX_INITIALIZER;
+  pthread_cond_t start_cond = PTHREAD_COND_INITIALIZER;
+  pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+  unsigned int generation = 0;
+  size_t remaining = 0;
+  bool stopping = false;
+  const std::vector<int> *numbers = nullptr;
+  const InputMatrix *inputs = nullptr;
+
+  bool takeTask(Worker *worker, size_t &task);
+  void runStimulus(Worker *worker, size_t task);
+  void work(Worker *worker);
+  static void *thread_helper(void *instance);
+
+public:
+  StimulusPool(SNN *network, int number_workers);
+  StimulusPool(const StimulusPool &) = delete;
+  StimulusPool &operator=(const StimulusPool &) = delete;
+  ~StimulusPool();
+
+  void run(const std::vector<int> &stimulus_numbers,
+           const InputMatrix &stimulus_inputs);
+  int size() const { return static_cast<int>(workers.size()); }
+};
+
+#endif // !STIMULUS_POOL
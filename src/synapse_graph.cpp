@@ -0,0 +1,167 @@
+#include "synapse_graph.hpp"
+#include "neuron.hpp"
+
+/**
+ * @brief Register the nodes of the graph.
+ *
+ * The position of a Neuron in `neurons` is its node number.
+ *
+ * @param neurons all `Neuron`s of the network (SNN::neurons)
+ */
+void SynapseGraph::setNodes(const std::vector<Neuron *> &neurons) {
+  node_group.clear();
+  node_index.clear();
+  node_group.reserve(neurons.size());
+  node_index.reserve(neurons.size());
+  for (auto neuron : neurons) {
+    node_group.push_back(neuron->getGroup());
+    node_index.push_back(neuron->getIndex());
+  }
+}
+
+/**
+ * @brief Add an edge to the pending edges.
+ *
+ * Safe to call from several threads. The edge is not visible through the
+ * outgoing edge accessors until the next SynapseGraph::freeze.
+ *
+ * @param from origin node
+ * @param to destination node
+ * @param weight edge weight
+ * @param delay synaptic delay in timestamps
+ */
+void SynapseGraph::addEdge(uint32_t from, uint32_t to, double weight,
+                           int delay) {
+  pthread_mutex_lock(&edge_tex);
+  pending_from.push_back(from);
+  pending_to.push_back(to);
+  pending_weight.push_back(weight);
+  pending_delay.push_back(delay);
+  pthread_mutex_unlock(&edge_tex);
+}
+
+/**
+ * @brief Make room for `count` more pending edges, before adding many.
+ */
+void SynapseGraph::reserve(size_t count) {
+  pthread_mutex_lock(&edge_tex);
+  size_t size = pending_from.size() + count;
+  pending_from.reserve(size);
+  pending_to.reserve(size);
+  pending_weight.reserve(size);
+  pending_delay.reserve(size);
+  pthread_mutex_unlock(&edge_tex);
+}
+
+/**
+ * @brief Move all pending edges into the compressed sparse row arrays.
+ *
+ * Edges already frozen are kept and come before the pending edges of the same
+ * origin. Does nothing if there are no pending edges.
+ */
+void SynapseGraph::freeze() {
+  size_t n = node_group.size();
+  if (pending_from.empty() && offsets.size() == n + 1) {
+    return;
+  }
+
+  // count outgoing edges per node, then prefix sum into offsets
+  std::vector<uint32_t> new_offsets(n + 1, 0);
+  if (offsets.size() == n + 1) {
+    for (size_t node = 0; node < n; node++) {
+      new_offsets[node + 1] = offsets[node + 1] - offsets[node];
+    }
+  }
+  for (auto from : pending_from) {
+    new_offsets[from + 1]++;
+  }
+  for (size_t node = 0; node < n; node++) {
+    new_offsets[node + 1] += new_offsets[node];
+  }
+
+  size_t m = new_offsets[n];
+  std::vector<uint32_t> new_targets(m);
+  std::vector<double> new_weights(m);
+  std::vector<int> new_delays(m);
+  std::vector<uint32_t> cursor(new_offsets.begin(), new_offsets.end() - 1);
+
+  if (offsets.size() == n + 1) {
+    for (size_t node = 0; node < n; node++) {
+      for (uint32_t e = offsets[node]; e < offsets[node + 1]; e++) {
+        uint32_t to = cursor[node]++;
+        new_targets[to] = targets[e];
+        new_weights[to] = weights[e];
+        new_delays[to] = delays[e];
+      }
+    }
+  }
+  for (size_t i = 0; i < pending_from.size(); i++) {
+    uint32_t to = cursor[pending_from[i]]++;
+    new_targets[to] = pending_to[i];
+    new_weights[to] = pending_weight[i];
+    new_delays[to] = pending_delay[i];
+  }
+
+  offsets.swap(new_offsets);
+  targets.swap(new_targets);
+  weights.swap(new_weights);
+  delays.swap(new_delays);
+
+  // release the pending storage, it is not needed until the graph changes
+  std::vector<uint32_t>().swap(pending_from);
+  std::vector<uint32_t>().swap(pending_to);
+  std::vector<double>().swap(pending_weight);
+  std::vector<int>().swap(pending_delay);
+
+  if (incoming) {
+    buildIncoming();
+  }
+}
+
+/**
+ * @brief Enable or disable the incoming edge mirror.
+ *
+ * @param build `true` to maintain the mirror on every SynapseGraph::freeze
+ */
+void SynapseGraph::setIncoming(bool build) {
+  incoming = build;
+  if (!incoming) {
+    std::vector<uint32_t>().swap(in_offsets);
+    std::vector<uint32_t>().swap(in_edges);
+  } else if (offsets.size() == node_group.size() + 1) {
+    buildIncoming();
+  }
+}
+
+void SynapseGraph::buildIncoming() {
+  size_t n = node_group.size();
+  in_offsets.assign(n + 1, 0);
+  for (auto to : targets) {
+    in_offsets[to + 1]++;
+  }
+  for (size_t node = 0; node < n; node++) {
+    in_offsets[node + 1] += in_offsets[node];
+  }
+  in_edges.resize(targets.size());
+  std::vector<uint32_t> cursor(in_offsets.begin(), in_offsets.end() - 1);
+  for (uint32_t e = 0; e < targets.size(); e++) {
+    in_edges[cursor[targets[e]]++] = e;
+  }
+}
+
+/**
+ * @brief Find the first frozen edge between two nodes.
+ *
+ * @return edge index or -1 if there is no such edge
+ */
+long SynapseGraph::findEdge(uint32_t from, uint32_t to) const {
+  if (offsets.size() != node_group.size() + 1) {
+    return -1;
+  }
+  for (uint32_t e = offsets[from]; e < offsets[from + 1]; e++) {
+    if (targets[e] == to) {
+      return e;
+    }
+  }
+  return -1;
+}
@@ -0,0 +1,99 @@
+/** @file */
+#ifndef SYNAPSE_GRAPH
+#define SYNAPSE_GRAPH
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <pthread.h>
+#include <vector>
+
+class Neuron;
+class NeuronGroup;
+
+/**
+ * @brief Synapses of the SNN in compressed sparse row form.
+ *
+ * Every Neuron is a node numbered by its position in SNN::neurons
+ * (Neuron::getGlobalIndex). While the network is built edges are appended to
+ * a list of pending (from, to) pairs. SynapseGraph::freeze groups them by
+ * origin so the outgoing edges of a node are the contiguous slice
+ * [SynapseGraph::edgesBegin, SynapseGraph::edgesEnd) of the target, weight and
+ * delay arrays. Edges of a node keep the order they were added in.
+ *
+ * An incoming (compressed sparse column) mirror holding edge indices is only
+ * built when requested with SynapseGraph::setIncoming.
+ */
+class SynapseGraph {
+private:
+  // node -> (group, index in group)
+  std::vector<NeuronGroup *> node_group;
+  std::vector<uint32_t> node_index;
+
+  // pending edges
+  std::vector<uint32_t> pending_from;
+  std::vector<uint32_t> pending_to;
+  std::vector<double> pending_weight;
+  std::vector<int> pending_delay;
+  pthread_mutex_t edge_tex = PTHREAD_MUTEX_INITIALIZER;
+
+  // outgoing edges, offsets has one element per node plus one
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> targets;
+  std::vector<double> weights;
+  std::vector<int> delays;
+
+  // incoming edges, in_edges holds indices into the outgoing arrays
+  bool incoming = false;
+  std::vector<uint32_t> in_offsets;
+  std::vector<uint32_t> in_edges;
+
+  void buildIncoming();
+
+public:
+  SynapseGraph() = default;
+  SynapseGraph(const SynapseGraph &) = delete;
+  SynapseGraph &operator=(const SynapseGraph &) = delete;
+  ~SynapseGraph() { pthread_mutex_destroy(&edge_tex); }
+
+  void setNodes(const std::vector<Neuron *> &neurons);
+  void addEdge(uint32_t from, uint32_t to, double weight, int delay);
+  void reserve(size_t count);
+  void freeze();
+  void setIncoming(bool build);
+
+  bool isFrozen() const { return pending_from.empty(); }
+  size_t nodeCount() const { return node_group.size(); }
+  size_t edgeCount() const { return targets.size() + pending_from.size(); }
+
+  // outgoing edges, only valid once frozen
+  uint32_t edgesBegin(uint32_t node) const { return offsets[node]; }
+  uint32_t edgesEnd(uint32_t node) const { return offsets[node + 1]; }
+  uint32_t getTarget(uint32_t edge) const { return targets[edge]; }
+  double getWeight(uint32_t edge) const { return weights[edge]; }
+  int getDelay(uint32_t edge) const { return delays[edge]; }
+  void setWeight(uint32_t edge, double weight) { weights[edge] = weight; }
+  void setDelay(uint32_t edge, int delay) { delays[edge] = delay; }
+  long findEdge(uint32_t from, uint32_t to) const;
+
+  // every frozen edge at once, by edge index, stable until edges are added
+  size_t frozenEdgeCount() const { return targets.size(); }
+  const double *weightData() const { return weights.data(); }
+  const int *delayData() const { return delays.data(); }
+  void setWeights(const double *values) {
+    std::copy(values, values + weights.size(), weights.begin());
+  }
+  void setDelays(const int *values) {
+    std::copy(values, values + delays.size(), delays.begin());
+  }
+
+  // incoming edges, only valid once frozen with SynapseGraph::setIncoming
+  uint32_t incomingBegin(uint32_t node) const { return in_offsets[node]; }
+  uint32_t incomingEnd(uint32_t node) const { return in_offsets[node + 1]; }
+  uint32_t getIncomingEdge(uint32_t i) const { return in_edges[i]; }
+
+  NeuronGroup *getGroup(uint32_t node) const { return node_group[node]; }
+  uint32_t getIndex(uint32_t node) const { return node_index[node]; }
+};
+
+#endif // !SYNAPSE_GRAPH
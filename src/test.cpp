@@ -1,6 +1,17 @@
+#include "calendar_queue.hpp"
+#include "decay_table.hpp"
 #include "file_reader.hpp"
+#include "input_matrix.hpp"
+#include "random_stream.hpp"
+#include "spike_buffer.hpp"
+#include "spsc_ring.hpp"
+#include "tick_engine.hpp"
+#include <algorithm>
+#include <cmath>
 #include <filesystem>
 #include <fstream>
+#include <pthread.h>
+#include <random>
 #include <unordered_map>
 #include <vector>
 
@@ -120,13 +131,380 @@ bool testAdjListParserParseAdjList() {
   return pass;
 }
 
+bool testCalendarQueueOrder() {
+  bool pass = true;
+  Log lg;
+  CalendarQueue<int> q(4);
+
+  // out of order pushes, equal timestamps must come back in push order
+  // and pushing past the initial span has to grow the ring
+  std::vector<std::pair<int, int>> pushes = {
+      {5, 0}, {1, 1}, {5, 2}, {0, 3}, {12, 4}, {1, 5}, {3, 6}};
+  for (auto p : pushes) {
+    q.push(p.second, p.first);
+  }
+  std::vector<int> expected = {3, 1, 5, 6, 0, 2, 4};
+  for (auto e : expected) {
+    int got = q.pop();
+    if (got != e) {
+      lg.value(ERROR, "CalendarQueue popped %d", got);
+      lg.value(ERROR, "expected %d", e);
+      pass = false;
+    }
+  }
+  if (!q.empty()) {
+    lg.log(ERROR, "CalendarQueue not empty after popping every element");
+    pass = false;
+  }
+
+  // late pushes land in the bucket being drained
+  q.clear();
+  q.push(0, 10);
+  q.push(1, 11);
+  q.pop();
+  q.push(2, 4);
+  if (q.pop() != 2 || q.pop() != 1) {
+    lg.log(ERROR, "CalendarQueue did not place a late push in the current "
+                  "bucket");
+    pass = false;
+  }
+
+  // clear forgets the last popped timestamp
+  q.clear();
+  q.push(7, 0);
+  if (q.currentTime() != 0 || q.pop() != 7) {
+    lg.log(ERROR, "CalendarQueue did not restart at 0 after clear");
+    pass = false;
+  }
+  return pass;
+}
+
+bool testDecayTableMatchesReference() {
+  Log lg;
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<> potential(-8.0, 30.0);
+  std::uniform_int_distribution<> timestamp(0, 3000);
+  double v_rest = -7.0;
+
+  for (double tau : {1.5, 20.0, 150.0, 5000.0}) {
+    DecayTable table;
+    table.build(tau, 400); // shorter than most decays, covers std::pow too
+    for (int i = 0; i < 10000; i++) {
+      double v = potential(gen);
+      int from = timestamp(gen);
+      int to = timestamp(gen);
+
+      double expected = v;
+      int last = DecayTable::reference(expected, v_rest, tau, from, to);
+      int steps = DecayTable::steps(from, to);
+      double got = table.decay(v, v_rest, steps);
+
+      if (last != from + DecayTable::time_step * steps) {
+        lg.value(ERROR, "DecayTable::steps last decay %d",
+                 from + DecayTable::time_step * steps);
+        lg.value(ERROR, "reference last decay %d", last);
+        return false;
+      }
+      if (std::abs(got - expected) > 1e-9 * std::max(1.0, std::abs(expected))) {
+        lg.value(ERROR, "DecayTable::decay differs from the reference by %lf",
+                 got - expected);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool testRoundKernelMatchesScalar() {
+  Log lg;
+  RoundKernel kernel = selectRoundKernel();
+  std::mt19937 gen(2);
+  std::uniform_real_distribution<> value(-8.0, 8.0);
+  std::bernoulli_distribution on(0.7);
+
+  // odd sizes so the vector loops leave a scalar tail
+  for (size_t n : {1, 3, 4, 7, 8, 13, 37, 100}) {
+    std::vector<double> expected(n), got(n), input(n), threshold(n), active(n);
+    for (size_t j = 0; j < n; j++) {
+      expected[j] = got[j] = value(gen);
+      input[j] = static_cast<float>(value(gen));
+      threshold[j] = value(gen);
+      active[j] = on(gen);
+    }
+    std::vector<uint32_t> expected_fired(n), got_fired(n);
+    size_t expected_count =
+        accumulateRoundScalar(expected.data(), input.data(), threshold.data(),
+                              active.data(), n, expected_fired.data());
+    size_t got_count = kernel(got.data(), input.data(), threshold.data(),
+                              active.data(), n, got_fired.data());
+
+    expected_fired.resize(expected_count);
+    got_fired.resize(got_count);
+    if (expected != got || expected_fired != got_fired) {
+      lg.string(ERROR, "%s round kernel differs from the scalar kernel",
+                roundKernelName(kernel));
+      lg.value(ERROR, "lanes %d", static_cast<int>(n));
+      return false;
+    }
+  }
+  return true;
+}
+
+void *pushSequence(void *arg) {
+  SpscRing<int> *ring = static_cast<SpscRing<int> *>(arg);
+  for (int i = 0; i < 100000; i++) {
+    while (!ring->push(i)) {
+    }
+  }
+  return nullptr;
+}
+
+bool testSpscRingOrder() {
+  Log lg;
+  // small ring so the producer keeps running into a full ring
+  SpscRing<int> ring(64);
+  pthread_t producer;
+  pthread_create(&producer, nullptr, pushSequence, &ring);
+
+  int expected = 0;
+  bool pass = true;
+  while (expected < 100000) {
+    ring.drain([&](int got) {
+      if (got != expected && pass) {
+        lg.value(ERROR, "SpscRing popped %d", got);
+        lg.value(ERROR, "expected %d", expected);
+        pass = false;
+      }
+      expected++;
+    });
+  }
+  pthread_join(producer, nullptr);
+
+  if (!ring.empty()) {
+    lg.log(ERROR, "SpscRing not empty after draining every element");
+    pass = false;
+  }
+  return pass;
+}
+
+bool testSpikeBufferOrder() {
+  Log lg;
+  SpikeBuffer buffer;
+  bool pass = true;
+  // spans several chunks, twice so the second round reuses them
+  for (uint32_t round = 0; round < 2; round++) {
+    for (uint32_t i = 0; i < 10000; i++) {
+      buffer.push({i, round, i % 200});
+    }
+    uint32_t expected = 0;
+    buffer.forEachChunk([&](const SpikeRecord *records, size_t count) {
+      for (size_t i = 0; i < count; i++, expected++) {
+        if ((records[i].neuron != expected || records[i].stimulus != round) &&
+            pass) {
+          lg.value(ERROR, "SpikeBuffer returned neuron %d",
+                   static_cast<int>(records[i].neuron));
+          lg.value(ERROR, "expected %d", static_cast<int>(expected));
+          pass = false;
+        }
+      }
+    });
+    if (expected != 10000 || buffer.size() != 10000) {
+      lg.value(ERROR, "SpikeBuffer returned %d records",
+               static_cast<int>(expected));
+      pass = false;
+    }
+    buffer.clear();
+  }
+  if (buffer.size() != 0) {
+    lg.log(ERROR, "SpikeBuffer not empty after clear");
+    pass = false;
+  }
+  return pass;
+}
+
+bool testInputFileReaderSeek() {
+  Log lg;
+  bool pass = true;
+  std::vector<std::string> lines = {"0.1 0.2", "", "1,2,3", "last"};
+  std::ofstream writeFile("./readerTest.txt");
+  writeFile << lines[0] << "\n" << lines[1] << "\n" << lines[2] << "\n"
+            << lines[3]; // no newline at the end
+  writeFile.close();
+
+  InputFileReader reader("./readerTest.txt", 2);
+  std::vector<std::string> read;
+  read.emplace_back(reader.nextLine());
+  reader.setToLine(0);
+  for (size_t i = 0; i < lines.size() + 1; i++) {
+    read.emplace_back(reader.nextLine());
+  }
+  std::vector<std::string> expected = {lines[2], lines[0], lines[1],
+                                       lines[2], lines[3], ""};
+  for (size_t i = 0; i < expected.size(); i++) {
+    if (read[i] != expected[i]) {
+      lg.value(ERROR, "InputFileReader wrong line at read %d",
+               static_cast<int>(i));
+      pass = false;
+    }
+  }
+  if (reader.lineCount() != lines.size()) {
+    lg.value(ERROR, "InputFileReader counted %d lines",
+             static_cast<int>(reader.lineCount()));
+    pass = false;
+  }
+  std::filesystem::remove("./readerTest.txt");
+  return pass;
+}
+
+bool testInputFileReaderFormats() {
+  Log lg;
+  bool pass = true;
+  double values[4];
+  std::vector<std::pair<std::string, std::vector<double>>> lines = {
+      {"0.1 0.2 1.5 -3", {0.1, 0.2, 1.5, -3}},
+      {"1,2, 3 ,4", {1, 2, 3, 4}},
+      {"  +1e-1;.5", {0.1, 0.5, 0, 0}}};
+  for (auto &line : lines) {
+    InputFileReader::parseValues(line.first, values, 4);
+    if (!std::equal(values, values + 4, line.second.begin())) {
+      lg.string(ERROR, "InputFileReader::parseValues failed on \"%s\"",
+                line.first.c_str());
+      pass = false;
+    }
+  }
+
+  // 3 x 2 float32 array in Fortran order, as written by np.save
+  std::string header =
+      "{'descr': '<f4', 'fortran_order': True, 'shape': (3, 2), }";
+  header.append(64 - (10 + header.size() + 1) % 64, ' ');
+  header += '\n';
+  std::ofstream writeFile("./readerTest.npy", std::ios::binary);
+  writeFile.write("\x93NUMPY\x01\x00", 8);
+  writeFile.put(header.size() & 0xff).put(header.size() >> 8);
+  writeFile << header;
+  float columns[6] = {0, 2, 4, 1, 3, 5};
+  writeFile.write(reinterpret_cast<const char *>(columns), sizeof(columns));
+  writeFile.close();
+
+  InputFileReader reader("./readerTest.npy", 1);
+  std::vector<double> row(3);
+  reader.nextStimulus(row);
+  if (reader.lineCount() != 3 || row != std::vector<double>{2, 3, 0}) {
+    lg.value(ERROR, "InputFileReader read %d npy rows",
+             static_cast<int>(reader.lineCount()));
+    pass = false;
+  }
+  std::filesystem::remove("./readerTest.npy");
+  return pass;
+}
+
+bool testInputMatrixStrides() {
+  Log lg;
+  bool pass = true;
+  // 3 x 4 view into the transpose of a 4 x 3 uint8 array
+  uint8_t pixels[4][3];
+  float floats[3][4];
+  std::vector<std::vector<double>> rows(3, std::vector<double>(4));
+  for (size_t i = 0; i < 3; i++) {
+    for (size_t j = 0; j < 4; j++) {
+      pixels[j][i] = i * 4 + j;
+      floats[i][j] = i * 4 + j;
+      rows[i][j] = (i * 4 + j) / 2.0;
+    }
+  }
+  InputMatrix transposed(pixels, 3, 4, 1, 3, InputMatrix::Type::UINT8, 0.5);
+  InputMatrix contiguous(floats, 3, 4, 4 * sizeof(float), sizeof(float),
+                         InputMatrix::Type::FLOAT32, 0.5);
+  InputMatrix copied(rows);
+  InputMatrix moved(std::move(copied));
+  for (size_t i = 0; i < 3; i++) {
+    for (size_t j = 0; j < 4; j++) {
+      double expected = (i * 4 + j) / 2.0;
+      if ((transposed.at(i, j) != expected ||
+           contiguous.at(i, j) != expected || moved.at(i, j) != expected) &&
+          pass) {
+        lg.value(ERROR, "InputMatrix wrong at row %d", static_cast<int>(i));
+        pass = false;
+      }
+    }
+  }
+  if (moved.rows() != 3 || moved.columns() != 4) {
+    lg.log(ERROR, "InputMatrix wrong dimensions");
+    pass = false;
+  }
+  return pass;
+}
+
+bool testRandomStreamPhilox() {
+  bool pass = true;
+  Log lg;
+  // known answers of Philox4x32-10 from Random123
+  uint32_t counters[3][4] = {{0, 0, 0, 0},
+                             {~0u, ~0u, ~0u, ~0u},
+                             {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}};
+  uint32_t keys[3][2] = {{0, 0}, {~0u, ~0u}, {0xa4093822, 0x299f31d0}};
+  uint32_t expected[3][4] = {{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+                             {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+                             {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+  for (int i = 0; i < 3; i++) {
+    RandomStream::philox(counters[i], keys[i]);
+    for (int j = 0; j < 4; j++) {
+      if (counters[i][j] != expected[i][j]) {
+        lg.value(ERROR, "Philox vector %d wrong", i);
+        pass = false;
+      }
+    }
+  }
+
+  // draws only depend on the key and the draw number
+  RandomStream sequential(7, Random_t::Timestamps, 3, 1, 2);
+  std::vector<uint32_t> draws(11);
+  for (auto &d : draws) {
+    d = sequential();
+  }
+  for (size_t i = 0; i < draws.size(); i++) {
+    RandomStream skipped(7, Random_t::Timestamps, 3, 1, 2);
+    skipped.discard(i);
+    if (skipped() != draws[i]) {
+      lg.value(ERROR, "Draw %d differs after discard", static_cast<int>(i));
+      pass = false;
+    }
+  }
+  RandomStream other(7, Random_t::Timestamps, 3, 2, 1);
+  RandomStream purpose(7, Random_t::Edge, 3, 1, 2);
+  if (other() == draws[0] || purpose() == draws[0]) {
+    lg.log(ERROR, "Different keys gave the same draw");
+    pass = false;
+  }
+
+  RandomStream bounded(1, Random_t::Synapses);
+  for (int i = 0; i < 1000; i++) {
+    double u = bounded.uniform();
+    if (bounded.below(5) >= 5 || u < 0 || u >= 1) {
+      lg.log(ERROR, "Draw out of range");
+      pass = false;
+      break;
+    }
+  }
+  return pass;
+}
+
 typedef struct _function {
   bool (*func)();
   std::string name;
 } Test;
 int main() {
   std::vector<Test> tests = {
-      {testAdjListParserParseAdjList, "AdjListParser::parseAdjList"}};
+      {testAdjListParserParseAdjList, "AdjListParser::parseAdjList"},
+      {testCalendarQueueOrder, "CalendarQueue::push/pop"},
+      {testDecayTableMatchesReference, "DecayTable::decay"},
+      {testRoundKernelMatchesScalar, "TickEngine round kernel"},
+      {testSpscRingOrder, "SpscRing::push/drain"},
+      {testSpikeBufferOrder, "SpikeBuffer::push/clear"},
+      {testInputMatrixStrides, "InputMatrix::at"},
+      {testRandomStreamPhilox, "RandomStream"},
+      {testInputFileReaderSeek, "InputFileReader::setToLine"},
+      {testInputFileReaderFormats, "InputFileReader::nextStimulus"}};
   for (auto f : tests) {
     if (!f.func()) {
       std::cout << " " << f.name << " Failed \n";
@@ -0,0 +1,207 @@
+#include "tick_engine.hpp"
+#include "neuron_group.hpp"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TICK_ENGINE_X86
+#endif
+
+size_t accumulateRoundScalar(double *potential, const double *input,
+                             const double *threshold, const double *active,
+                             size_t n, uint32_t *fired) {
+  size_t number_fired = 0;
+  for (size_t j = 0; j < n; j++) {
+    if (active[j] != 0) {
+      potential[j] += input[j];
+      if (potential[j] >= threshold[j]) {
+        fired[number_fired++] = j;
+      }
+    }
+  }
+  return number_fired;
+}
+
+#ifdef TICK_ENGINE_X86
+__attribute__((target("avx2"))) static size_t
+accumulateRoundAVX2(double *potential, const double *input,
+                    const double *threshold, const double *active, size_t n,
+                    uint32_t *fired) {
+  size_t number_fired = 0;
+  size_t j = 0;
+  const __m256d zero = _mm256_setzero_pd();
+  for (; j + 4 <= n; j += 4) {
+    __m256d v = _mm256_loadu_pd(potential + j);
+    __m256d on =
+        _mm256_cmp_pd(_mm256_loadu_pd(active + j), zero, _CMP_NEQ_OQ);
+    v = _mm256_blendv_pd(v, _mm256_add_pd(v, _mm256_loadu_pd(input + j)), on);
+    _mm256_storeu_pd(potential + j, v);
+
+    __m256d fire = _mm256_and_pd(
+        on, _mm256_cmp_pd(v, _mm256_loadu_pd(threshold + j), _CMP_GE_OQ));
+    int bits = _mm256_movemask_pd(fire);
+    while (bits) {
+      fired[number_fired++] = j + __builtin_ctz(bits);
+      bits &= bits - 1;
+    }
+  }
+  size_t tail = accumulateRoundScalar(potential + j, input + j, threshold + j,
+                                      active + j, n - j, fired + number_fired);
+  for (size_t k = number_fired; k < number_fired + tail; k++) {
+    fired[k] += j;
+  }
+  return number_fired + tail;
+}
+
+__attribute__((target("avx512f"))) static size_t
+accumulateRoundAVX512(double *potential, const double *input,
+                      const double *threshold, const double *active, size_t n,
+                      uint32_t *fired) {
+  size_t number_fired = 0;
+  size_t j = 0;
+  const __m512d zero = _mm512_setzero_pd();
+  for (; j + 8 <= n; j += 8) {
+    __m512d v = _mm512_loadu_pd(potential + j);
+    __mmask8 on =
+        _mm512_cmp_pd_mask(_mm512_loadu_pd(active + j), zero, _CMP_NEQ_OQ);
+    v = _mm512_mask_add_pd(v, on, v, _mm512_loadu_pd(input + j));
+    _mm512_storeu_pd(potential + j, v);
+
+    unsigned bits = _mm512_mask_cmp_pd_mask(
+        on, v, _mm512_loadu_pd(threshold + j), _CMP_GE_OQ);
+    while (bits) {
+      fired[number_fired++] = j + __builtin_ctz(bits);
+      bits &= bits - 1;
+    }
+  }
+  size_t tail = accumulateRoundScalar(potential + j, input + j, threshold + j,
+                                      active + j, n - j, fired + number_fired);
+  for (size_t k = number_fired; k < number_fired + tail; k++) {
+    fired[k] += j;
+  }
+  return number_fired + tail;
+}
+#endif
+
+/**
+ * @brief Widest RoundKernel the CPU supports.
+ */
+RoundKernel selectRoundKernel() {
+#ifdef TICK_ENGINE_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return accumulateRoundAVX512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return accumulateRoundAVX2;
+  }
+#endif
+  return accumulateRoundScalar;
+}
+
+const char *roundKernelName(RoundKernel kernel) {
+#ifdef TICK_ENGINE_X86
+  if (kernel == accumulateRoundAVX512) {
+    return "avx512";
+  }
+  if (kernel == accumulateRoundAVX2) {
+    return "avx2";
+  }
+#endif
+  return "scalar";
+}
+
+TickEngine::TickEngine(NeuronGroup *group)
+    : group(group), kernel(selectRoundKernel()) {}
+
+/**
+ * @brief Integrate every message of one tick.
+ *
+ * @param timestamp the tick
+ * @param batch messages for `timestamp` in queue order
+ */
+void TickEngine::run(int timestamp, const std::vector<Message> &batch) {
+  NeuronState &state = group->getState();
+
+  // order by target, positions are unique so this keeps queue order
+  order.resize(batch.size());
+  for (size_t p = 0; p < batch.size(); p++) {
+    order[p] = static_cast<uint64_t>(batch[p].target) << 32 | p;
+  }
+  std::sort(order.begin(), order.end());
+
+  lanes.clear();
+  for (uint32_t k = 0; k < order.size(); k++) {
+    uint32_t neuron = order[k] >> 32;
+    if (lanes.empty() || lanes.back().neuron != neuron) {
+      lanes.push_back(Lane{neuron, k, 0});
+    }
+    lanes.back().count++;
+  }
+
+  // lanes with more messages first, round r then covers a prefix of lanes
+  std::stable_sort(lanes.begin(), lanes.end(),
+                   [](const Lane &a, const Lane &b) { return a.count > b.count; });
+
+  size_t number_lanes = lanes.size();
+  potential.resize(number_lanes);
+  threshold.resize(number_lanes);
+  active.resize(number_lanes);
+  input.resize(number_lanes);
+  fired.resize(number_lanes);
+
+  // refractory mask and decay, every message of a refractory lane is dropped
+  for (size_t j = 0; j < number_lanes; j++) {
+    uint32_t i = lanes[j].neuron;
+    if (timestamp < state.refractory_start[i] + state.refractory_duration[i]) {
+      active[j] = 0;
+    } else {
+      group->retroactiveDecay(i, timestamp);
+      active[j] = 1;
+    }
+    potential[j] = state.membrane_potential[i];
+    threshold[j] = state.activation_threshold[i];
+  }
+
+  spikes.clear();
+  size_t width = number_lanes;
+  for (uint32_t r = 0; width > 0; r++) {
+    while (width > 0 && lanes[width - 1].count <= r) {
+      width--;
+    }
+    for (size_t j = 0; j < width; j++) {
+      uint32_t position = order[lanes[j].begin + r];
+      input[j] = batch[position].message;
+    }
+
+    size_t number_fired = kernel(potential.data(), input.data(),
+                                 threshold.data(), active.data(), width,
+                                 fired.data());
+
+    for (size_t f = 0; f < number_fired; f++) {
+      uint32_t j = fired[f];
+      uint32_t i = lanes[j].neuron;
+      spikes.push_back(
+          Spike{static_cast<uint32_t>(order[lanes[j].begin + r]), i,
+                potential[j]});
+      potential[j] = state.refractory_potential[i];
+      if (state.refractory_duration[i] > 0) {
+        active[j] = 0;
+      }
+    }
+  }
+
+  for (size_t j = 0; j < number_lanes; j++) {
+    state.membrane_potential[lanes[j].neuron] = potential[j];
+  }
+
+  // send spikes in the order the event driven engine would have
+  std::sort(spikes.begin(), spikes.end(),
+            [](const Spike &a, const Spike &b) { return a.position < b.position; });
+  for (const Spike &spike : spikes) {
+    state.last_fire[spike.neuron] = timestamp;
+    state.refractory_start[spike.neuron] = timestamp;
+    group->propagate(spike.neuron, spike.potential);
+    group->addActivation(spike.neuron, timestamp);
+  }
+}
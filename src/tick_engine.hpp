@@ -0,0 +1,85 @@
+/** @file */
+#ifndef TICK_ENGINE
+#define TICK_ENGINE
+
+#include "message.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class NeuronGroup;
+
+/**
+ * @brief Accumulate one message into every lane of a round.
+ *
+ * For every lane `j < n` with `active[j] != 0` adds `input[j]` to
+ * `potential[j]` and writes `j` to `fired` if the result is at least
+ * `threshold[j]`.
+ *
+ * @return number of lanes written to `fired`
+ */
+typedef size_t (*RoundKernel)(double *potential, const double *input,
+                              const double *threshold, const double *active,
+                              size_t n, uint32_t *fired);
+
+size_t accumulateRoundScalar(double *potential, const double *input,
+                             const double *threshold, const double *active,
+                             size_t n, uint32_t *fired);
+RoundKernel selectRoundKernel();
+const char *roundKernelName(RoundKernel kernel);
+
+/**
+ * @brief Clock driven integration of a NeuronGroup.
+ *
+ * Instead of running every Message on its own, TickEngine::run takes all
+ * messages of a tick and integrates them neuron by neuron, which pays off when
+ * most neurons receive input on most ticks.
+ *
+ * The messages of a tick are ordered by target, keeping queue order for a
+ * target. Every target neuron is a lane. Lanes in refractory are masked, the
+ * others are decayed to the tick. Round `r` then accumulates the `r`-th message
+ * of every lane and checks the threshold with a RoundKernel (AVX-512, AVX2 or
+ * scalar, picked at runtime). A neuron that fires is reset to its refractory
+ * potential and masked for the rest of the tick if its refractory duration is
+ * not 0. Spikes are sent in the order of the messages that triggered them.
+ *
+ * Every neuron sees the same additions in the same order as with
+ * NeuronGroup::runNeuron, and the kernels do not contract to FMA, so the
+ * activations are identical to the event driven engine. Messages with a delay
+ * of 0 land in the tick being integrated and form the next batch, just like
+ * they are run after every queued message of the tick by the event driven
+ * engine.
+ */
+class TickEngine {
+private:
+  struct Lane {
+    uint32_t neuron;
+    uint32_t begin; /**< first entry in TickEngine::order */
+    uint32_t count;
+  };
+  struct Spike {
+    uint32_t position; /**< position of the trigger in the batch */
+    uint32_t neuron;
+    double potential;
+  };
+
+  NeuronGroup *group;
+  RoundKernel kernel;
+
+  // scratch, kept between ticks
+  std::vector<uint64_t> order; /**< target << 32 | position */
+  std::vector<Lane> lanes;
+  std::vector<double> potential;
+  std::vector<double> threshold;
+  std::vector<double> active;
+  std::vector<double> input;
+  std::vector<uint32_t> fired;
+  std::vector<Spike> spikes;
+
+public:
+  TickEngine(NeuronGroup *group);
+  void run(int timestamp, const std::vector<Message> &batch);
+  RoundKernel getKernel() const { return kernel; }
+};
+
+#endif // !TICK_ENGINE